@@ -2,35 +2,130 @@
 #define VRUTILS_HPP
 
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <cmath> // for std::sqrt, std::fmax, std::atan2, std::asin, std::abs, M_PI
+#include <ctime>
+#include <type_traits>
 #include <openvr.h>
 #include "json.hpp"
+#include "transform.hpp"
 
-struct VRControllerData {
+// One published tracker sample. Plain fixed-width data so it can be copied
+// under data_mutex without allocating and moved with memcpy into ring
+// buffers, shared memory or files; the layout is checked below.
+struct alignas(64) VRControllerData {
+    int64_t time_ns;            // system clock at the poll, ns since the epoch
+    uint64_t sequence;          // bumped on every update of the device's slot
+    uint32_t device;            // tracked device index
+    int32_t role;               // 1 for left, 2 for right
+    float pose_x, pose_y, pose_z, pose_qx, pose_qy, pose_qz, pose_qw;
+    float vel_x, vel_y, vel_z;              // linear velocity (m/s), tracking space
+    float ang_vel_x, ang_vel_y, ang_vel_z;  // angular velocity (rad/s), tracking space
+    float trackpad_x, trackpad_y;
+    float trigger;
+    uint8_t buttons;            // VRButtonFlag bits currently held
+    uint8_t pressed_edges, released_edges;  // VRButtonFlag bits changed since the last sent sample
+    uint8_t flags;              // TrackerSampleFlag bits
+    float raw_x, raw_y, raw_z, raw_qx, raw_qy, raw_qz, raw_qw;  // pose before smoothing, equal to pose_* without a filter
+    uint32_t reserved[2];
+};
+static_assert(std::is_trivially_copyable<VRControllerData>::value, "VRControllerData is copied with memcpy");
+static_assert(sizeof(VRControllerData) == 128 && alignof(VRControllerData) == 64, "VRControllerData is two cache lines");
+static_assert(offsetof(VRControllerData, pose_x) == 24 && offsetof(VRControllerData, buttons) == 88,
+              "VRControllerData field offsets");
+
+// Handover from the VR thread to the server, guarded by data_mutex: the
+// latest sample of every device index and which of them are not sent yet,
+// so every device of a poll reaches the clients.
+struct TrackerSampleSlots {
+    VRControllerData latest[vr::k_unMaxTrackedDeviceCount] = {};
+    uint64_t pending = 0;       // bit per device index
+};
+static_assert(vr::k_unMaxTrackedDeviceCount <= 64, "TrackerSampleSlots::pending has a bit per device");
+
+// Pose of a device in the frame of a reference device, both from the same poll
+struct RelativePoseData {
+    int64_t time_ns;            // system clock at the poll, ns since the epoch
+    uint32_t device;            // tracked device index of the tool
+    uint32_t reference;         // tracked device index of the reference
+    float pose_x, pose_y, pose_z, pose_qx, pose_qy, pose_qz, pose_qw;
+    uint8_t flags;              // TrackerSampleFlag bits of either pose
+};
+
+// Pose of a base station, sent on its own channel when it moves
+struct TrackingReferenceData {
+    uint32_t index;
+    bool valid;  // false once the base station is lost
     double pose_x, pose_y, pose_z, pose_qx, pose_qy, pose_qz, pose_qw;
-    bool menu_button, trigger_button, trackpad_touch, trackpad_button, grip_button;
-    double trackpad_x, trackpad_y;
-    double trigger;
-    int role;  // 1 for left, 2 for right
+    std::string serial;
     std::string time;
+    int64_t time_ns;  // system clock when published, ns since the epoch
+};
+
+// Bits of VRControllerData::flags
+enum TrackerSampleFlag : uint8_t {
+    TrackerPredicted = 1 << 0   // dead-reckoned through a tracking dropout
+};
+
+// Button bits of VRControllerData::buttons and its edges
+enum VRButtonFlag : uint8_t {
+    ButtonMenu          = 1 << 0,
+    ButtonTrigger       = 1 << 1,
+    ButtonTrackpadTouch = 1 << 2,
+    ButtonTrackpad      = 1 << 3,
+    ButtonGrip          = 1 << 4
 };
 
+// Log levels below VIVE_LOG_MIN_LEVEL are compiled out of VIVE_LOG() call sites
+#ifndef VIVE_LOG_MIN_LEVEL
+#define VIVE_LOG_MIN_LEVEL 1 // Info
+#endif
+
 enum LogLevel {
-    Info,
-    Debug,
-    Warning,
-    Error
+    Debug = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3
 };
 
-// Logging function
-inline void logMessage(LogLevel level, const std::string& message) {
+inline LogLevel parseLogLevel(const char* name, LogLevel fallback) {
+    if (name == nullptr) return fallback;
+    std::string level(name);
+    if (level == "debug") return Debug;
+    if (level == "info") return Info;
+    if (level == "warning") return Warning;
+    if (level == "error") return Error;
+    return fallback;
+}
+
+// Runtime threshold on top of the compiled one, initialised from $VIVE_LOG_LEVEL
+inline std::atomic<int>& runtimeLogLevel() {
+    static std::atomic<int> level(parseLogLevel(std::getenv("VIVE_LOG_LEVEL"), Info));
+    return level;
+}
+
+inline void setLogLevel(LogLevel level) {
+    runtimeLogLevel().store(level, std::memory_order_relaxed);
+}
+
+inline bool logLevelEnabled(LogLevel level) {
+    return level >= VIVE_LOG_MIN_LEVEL && level >= runtimeLogLevel().load(std::memory_order_relaxed);
+}
+
+inline void writeLog(LogLevel level, const char* message) {
     switch (level) {
         case Info:
             std::cout << "[INFO] " << message << std::endl;
             break;
         case Debug:
-            // std::cout << "[DEBUG] " << message << std::endl;
+            std::cout << "[DEBUG] " << message << std::endl;
             break;
         case Warning:
             std::cerr << "[WARNING] " << message << std::endl;
@@ -41,53 +136,101 @@ inline void logMessage(LogLevel level, const std::string& message) {
     }
 }
 
-// Define a structure for Euler angles
-struct EulerAngle {
-    float x; // Roll
-    float y; // Pitch
-    float z; // Yaw
-};
-
-class Quaternion {
-public:
-    float w, x, y, z;
+// Optional sink that takes over formatting and output (see AsyncLogger).
+// site identifies the VIVE_LOG call site ("file:line"), nullptr for logMessage()
+using LogSink = void (*)(LogLevel level, const char* site, const char* format, va_list args);
 
-    Quaternion(float w, float x, float y, float z) : w(w), x(x), y(y), z(z) {}
+inline std::atomic<LogSink>& logSink() {
+    static std::atomic<LogSink> sink(nullptr);
+    return sink;
+}
 
-    Quaternion inverse() const {
-        return Quaternion(w, -x, -y, -z);
+// printf-style logging into a stack buffer, no heap allocation
+__attribute__((format(printf, 3, 4)))
+inline void logFormatted(LogLevel level, const char* site, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    LogSink sink = logSink().load(std::memory_order_acquire);
+    if (sink) {
+        sink(level, site, format, args);
+    } else {
+        char buffer[512];
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        writeLog(level, buffer);
     }
+    va_end(args);
+}
 
-    Quaternion operator*(const Quaternion& q) const {
-        return Quaternion(
-            w * q.w - x * q.x - y * q.y - z * q.z,
-            w * q.x + x * q.w + y * q.z - z * q.y,
-            w * q.y - x * q.z + y * q.w + z * q.x,
-            w * q.z + x * q.y - y * q.x + z * q.w
-        );
+// Logging function
+inline void logMessage(LogLevel level, const std::string& message) {
+    if (logLevelEnabled(level)) {
+        logFormatted(level, nullptr, "%s", message.c_str());
     }
-};
+}
+
+#define VIVE_LOG_STRINGIFY_(x) #x
+#define VIVE_LOG_STRINGIFY(x) VIVE_LOG_STRINGIFY_(x)
+
+// The arguments are only evaluated when the level is enabled
+#define VIVE_LOG(level, ...)                                                                          \
+    do {                                                                                              \
+        if ((level) >= VIVE_LOG_MIN_LEVEL && logLevelEnabled(level)) {                                \
+            logFormatted(level, __FILE__ ":" VIVE_LOG_STRINGIFY(__LINE__), __VA_ARGS__);              \
+        }                                                                                             \
+    } while (0)
 
 class VRUtils {
 public:
     static void resetJsonData(VRControllerData& data) {
-        data.pose_x = 0.0;
-        data.pose_y = 0.0;
-        data.pose_z = 0.0;
-        data.pose_qx = 0.0;
-        data.pose_qy = 0.0;
-        data.pose_qz = 0.0;
-        data.pose_qw = 0.0;
-        data.menu_button = false;
-        data.trigger_button = false;
-        data.trackpad_touch = false;
-        data.trackpad_button = false;
-        data.grip_button = false;
-        data.trackpad_x = 0.0;
-        data.trackpad_y = 0.0;
-        data.trigger = 0.0;
+        data = VRControllerData{};
         data.role = 1;
-        data.time = "";
+    }
+
+    // System clock in ns since the epoch, the time base of VRControllerData
+    static int64_t wallTimeNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Local time as "YYYY-mm-dd HH:MM:SS.mmm", the "time" field of the messages
+    static std::string formatTime(int64_t time_ns) {
+        std::time_t seconds = static_cast<std::time_t>(time_ns / 1000000000);
+        int milliseconds = static_cast<int>(time_ns / 1000000 % 1000);
+        std::tm local;
+        localtime_r(&seconds, &local);
+        char buffer[32];
+        size_t n = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+        std::snprintf(buffer + n, sizeof(buffer) - n, ".%03d", milliseconds);
+        return buffer;
+    }
+
+    // Map an OpenVR button id to the VRButtonFlag it drives (0 if unused)
+    static uint8_t buttonFlagFromId(uint32_t buttonId, bool touch) {
+        switch (buttonId) {
+            case vr::k_EButton_ApplicationMenu:  return touch ? 0 : ButtonMenu;
+            case vr::k_EButton_SteamVR_Trigger:  return touch ? 0 : ButtonTrigger;
+            case vr::k_EButton_SteamVR_Touchpad: return touch ? ButtonTrackpadTouch : ButtonTrackpad;
+            case vr::k_EButton_Grip:             return touch ? 0 : ButtonGrip;
+            default:                             return 0;
+        }
+    }
+
+    // Current VRButtonFlag bits of a controller state
+    static uint8_t buttonFlags(const vr::VRControllerState_t& state) {
+        uint8_t flags = 0;
+        flags |= (state.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_ApplicationMenu)) ? ButtonMenu : 0;
+        flags |= (state.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Trigger)) ? ButtonTrigger : 0;
+        flags |= (state.ulButtonTouched & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Touchpad)) ? ButtonTrackpadTouch : 0;
+        flags |= (state.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Touchpad)) ? ButtonTrackpad : 0;
+        flags |= (state.ulButtonPressed & vr::ButtonMaskFromId(vr::k_EButton_Grip)) ? ButtonGrip : 0;
+        return flags;
+    }
+
+    // Fill the input fields of data from a controller state
+    static void applyControllerState(const vr::VRControllerState_t& state, VRControllerData& data) {
+        data.buttons = buttonFlags(state);
+        data.trackpad_x = state.rAxis[0].x;
+        data.trackpad_y = state.rAxis[0].y;
+        data.trigger = state.rAxis[1].x;
     }
 
     static bool deviceIsConnected(vr::IVRSystem* pHMD, vr::TrackedDeviceIndex_t unDeviceIndex) {
@@ -102,7 +245,7 @@ public:
         for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
             if (deviceIsConnected(pHMD, i)) {
                 vr::ETrackedDeviceClass trackedDeviceClass = pHMD->GetTrackedDeviceClass(i);
-                logMessage(Debug, "[CONNECTED DEVICE " + std::to_string(i) + "]: class " + std::to_string(trackedDeviceClass));
+                VIVE_LOG(Debug, "[CONNECTED DEVICE %u]: class %d", i, trackedDeviceClass);
             }
         }
     }
@@ -113,11 +256,11 @@ public:
             controllerRole = pHMD->GetControllerRoleForTrackedDeviceIndex(i);
             if (controllerRole != vr::TrackedControllerRole_Invalid) {
                 if (controllerRole == vr::TrackedControllerRole_LeftHand) {
-                    logMessage(Debug, "[CONNECTED CONTROLLER " + std::to_string(i) + "]: role Left");
+                    VIVE_LOG(Debug, "[CONNECTED CONTROLLER %u]: role Left", i);
                 } else if (controllerRole == vr::TrackedControllerRole_RightHand) {
-                    logMessage(Debug, "[CONNECTED CONTROLLER " + std::to_string(i) + "]: role Right");
+                    VIVE_LOG(Debug, "[CONNECTED CONTROLLER %u]: role Right", i);
                 } else {
-                    logMessage(Debug, "[CONNECTED CONTROLLER " + std::to_string(i) + "]: role " + std::to_string(controllerRole));
+                    VIVE_LOG(Debug, "[CONNECTED CONTROLLER %u]: role %d", i, controllerRole);
                 }
             }
         }
@@ -135,22 +278,30 @@ public:
     }
 };
 
+// Conversions between OpenVR types and the transform library
 class VRTransformUtils {
 public:
     static vr::HmdQuaternion_t GetQuaternion(const vr::HmdMatrix34_t& m) {
         vr::HmdQuaternion_t q;
-
-        q.w = sqrt(std::fmax(0, 1 + m.m[0][0] + m.m[1][1] + m.m[2][2])) / 2;
-        q.x = sqrt(std::fmax(0, 1 + m.m[0][0] - m.m[1][1] - m.m[2][2])) / 2;
-        q.y = sqrt(std::fmax(0, 1 - m.m[0][0] + m.m[1][1] - m.m[2][2])) / 2;
-        q.z = sqrt(std::fmax(0, 1 - m.m[0][0] - m.m[1][1] + m.m[2][2])) / 2;
-        q.x = copysign(q.x, m.m[2][1] - m.m[1][2]);
-        q.y = copysign(q.y, m.m[0][2] - m.m[2][0]);
-        q.z = copysign(q.z, m.m[1][0] - m.m[0][1]);
-
+        transform::quaternionFromRotation<double>(m.m[0][0], m.m[0][1], m.m[0][2],
+                                                  m.m[1][0], m.m[1][1], m.m[1][2],
+                                                  m.m[2][0], m.m[2][1], m.m[2][2],
+                                                  q.w, q.x, q.y, q.z);
         return q;
     }
 
+    // Quaternions of poses[0, count) from one GetDeviceToAbsoluteTrackingPose
+    // call, in one loop without branches
+    static void GetQuaternions(const vr::TrackedDevicePose_t* poses, uint32_t count, vr::HmdQuaternion_t* out) {
+        for (uint32_t i = 0; i < count; i++) {
+            const vr::HmdMatrix34_t& m = poses[i].mDeviceToAbsoluteTracking;
+            transform::quaternionFromRotation<double>(m.m[0][0], m.m[0][1], m.m[0][2],
+                                                      m.m[1][0], m.m[1][1], m.m[1][2],
+                                                      m.m[2][0], m.m[2][1], m.m[2][2],
+                                                      out[i].w, out[i].x, out[i].y, out[i].z);
+        }
+    }
+
     static vr::HmdVector3_t GetPosition(const vr::HmdMatrix34_t& m) {
         vr::HmdVector3_t vector;
 
@@ -161,27 +312,25 @@ public:
         return vector;
     }
 
-    static EulerAngle QuaternionToEulerXYZ(const vr::HmdQuaternion_t& q) {
-        EulerAngle angles;
-
-        // Roll (x-axis rotation)
-        double sinr_cosp = 2 * (q.w * q.x + q.y * q.z);
-        double cosr_cosp = 1 - 2 * (q.x * q.x + q.y * q.y);
-        angles.x = std::atan2(sinr_cosp, cosr_cosp);
-
-        // Pitch (y-axis rotation)
-        double sinp = 2 * (q.w * q.y - q.z * q.x);
-        if (std::abs(sinp) >= 1)
-            angles.y = std::copysign(M_PI / 2, sinp); // use 90 degrees if out of range
-        else
-            angles.y = std::asin(sinp);
+    static transform::EulerXYZ<double> QuaternionToEulerXYZ(const vr::HmdQuaternion_t& q) {
+        return transform::Quaternion<double>{q.w, q.x, q.y, q.z}.toEulerXYZ();
+    }
 
-        // Yaw (z-axis rotation)
-        double siny_cosp = 2 * (q.w * q.z + q.x * q.y);
-        double cosy_cosp = 1 - 2 * (q.y * q.y + q.z * q.z);
-        angles.z = std::atan2(siny_cosp, cosy_cosp);
+    static transform::RigidTransform<float> ToRigidTransform(const vr::HmdMatrix34_t& m) {
+        return {{{{m.m[0][0], m.m[0][1], m.m[0][2]}, {m.m[1][0], m.m[1][1], m.m[1][2]}, {m.m[2][0], m.m[2][1], m.m[2][2]}}},
+                {m.m[0][3], m.m[1][3], m.m[2][3]}};
+    }
 
-        return angles;
+    static vr::HmdMatrix34_t ToMatrix34(const transform::RigidTransform<float>& t) {
+        vr::HmdMatrix34_t m;
+        const float translation[3] = {t.translation.x, t.translation.y, t.translation.z};
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                m.m[r][c] = t.rotation.m[r][c];
+            }
+            m.m[r][3] = translation[r];
+        }
+        return m;
     }
 };
 
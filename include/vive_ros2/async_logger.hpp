@@ -0,0 +1,70 @@
+#ifndef ASYNC_LOGGER_HPP
+#define ASYNC_LOGGER_HPP
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <thread>
+
+#include "VRUtils.hpp"
+
+// Asynchronous logger for the hot loops. Once started it becomes the
+// VIVE_LOG sink: producers format into a slot of a bounded lock-free MPSC
+// ring and return, a background thread does the (flushing) stream I/O.
+// When the ring is full the message is dropped and counted.
+class AsyncLogger {
+public:
+    static AsyncLogger& instance();
+
+    void start();
+    void stop();  // drains the remaining records
+
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    uint64_t suppressedCount() const { return suppressed.load(std::memory_order_relaxed); }
+
+    // Each VIVE_LOG call site may log this many messages per second; logMessage() is not limited
+    static constexpr uint32_t kRateLimitBurst = 10;
+
+private:
+    static constexpr size_t kCapacity = 1024;  // power of two
+    static constexpr size_t kMessageSize = 240;
+    static constexpr size_t kCallSites = 128;  // power of two
+
+    struct Record {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        uint32_t suppressed;
+        char text[kMessageSize];
+    };
+
+    // Rate limit state of one call site, keyed by its "file:line" literal
+    struct CallSite {
+        std::atomic<const char*> site{nullptr};
+        std::atomic<int64_t> window_start{0};
+        std::atomic<uint32_t> count{0};
+        std::atomic<uint32_t> suppressed{0};
+    };
+
+    AsyncLogger();
+    ~AsyncLogger();
+
+    static void sink(LogLevel level, const char* site, const char* format, va_list args);
+    bool push(LogLevel level, uint32_t suppressed_before, const char* format, va_list args);
+    bool pop();
+    CallSite* callSite(const char* key);
+    void drain();
+
+    Record records[kCapacity];
+    CallSite call_sites[kCallSites];
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) size_t dequeue_pos = 0;
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> suppressed{0};
+    uint64_t reported_dropped = 0;
+
+    std::atomic<bool> running{false};
+    std::thread worker;
+};
+
+#endif // ASYNC_LOGGER_HPP
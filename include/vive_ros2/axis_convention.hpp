@@ -0,0 +1,108 @@
+#ifndef AXIS_CONVENTION_HPP
+#define AXIS_CONVENTION_HPP
+
+// Axis conventions as signed permutations, resolved at compile time.
+//
+// A SignedPermutation<X, Y, Z> gives, for each output axis, the input axis it
+// is taken from (1 = x, 2 = y, 3 = z) and its sign, e.g. <-3, -1, 2> means
+// out = (-in.z, -in.x, in.y). Every convention is described by its mapping
+// into ROS REP-103; conversions between two conventions are composed from
+// those, so applying one is a few negations and moves with no branches.
+
+namespace axis {
+
+template <int X, int Y, int Z>
+struct SignedPermutation {
+    static constexpr int row(int i) { return i == 0 ? X : i == 1 ? Y : Z; }
+    static constexpr int source(int i) { return (row(i) < 0 ? -row(i) : row(i)) - 1; }
+    static constexpr int sign(int i) { return row(i) < 0 ? -1 : 1; }
+
+    // +1 for rotations, -1 when the handedness changes
+    static constexpr int determinant() {
+        // Parity of the permutation times the product of the signs
+        return (source(0) == 0 ? (source(1) == 1 ? 1 : -1)
+              : source(0) == 1 ? (source(1) == 2 ? 1 : -1)
+              : (source(1) == 0 ? 1 : -1)) * sign(0) * sign(1) * sign(2);
+    }
+
+    // Positions and linear velocities
+    template <typename T>
+    static constexpr void vector(T x, T y, T z, T& ox, T& oy, T& oz) {
+        const T in[3] = {x, y, z};
+        ox = sign(0) * in[source(0)];
+        oy = sign(1) * in[source(1)];
+        oz = sign(2) * in[source(2)];
+    }
+
+    // Angular velocities and quaternion vector parts flip with the handedness
+    template <typename T>
+    static constexpr void pseudovector(T x, T y, T z, T& ox, T& oy, T& oz) {
+        vector(x, y, z, ox, oy, oz);
+        ox *= determinant();
+        oy *= determinant();
+        oz *= determinant();
+    }
+
+    // q' = (det(M) M q.xyz, q.w), the rotation M R M^T
+    template <typename T>
+    static constexpr void quaternion(T x, T y, T z, T w, T& ox, T& oy, T& oz, T& ow) {
+        pseudovector(x, y, z, ox, oy, oz);
+        ow = w;
+    }
+};
+
+// Conventions, each given by the mapping of its coordinates into ROS
+struct Ros {           // REP-103: x forward, y left, z up
+    using ToRos = SignedPermutation<1, 2, 3>;
+};
+struct SteamVR {       // x right, y up, z backward
+    using ToRos = SignedPermutation<-3, -1, 2>;
+};
+struct Unity {         // x right, y up, z forward (left-handed)
+    using ToRos = SignedPermutation<3, -1, 2>;
+};
+
+namespace detail {
+
+// Row of the inverse of P: the output axis that input axis i goes to
+template <typename P>
+constexpr int inverseRow(int i) {
+    return P::source(0) == i ? P::sign(0) * 1 : P::source(1) == i ? P::sign(1) * 2 : P::sign(2) * 3;
+}
+
+// Row i of A * B
+template <typename A, typename B>
+constexpr int composeRow(int i) {
+    return A::sign(i) * B::row(A::source(i));
+}
+
+template <typename P>
+using Inverse = SignedPermutation<inverseRow<P>(0), inverseRow<P>(1), inverseRow<P>(2)>;
+
+template <typename A, typename B>
+using Compose = SignedPermutation<composeRow<A, B>(0), composeRow<A, B>(1), composeRow<A, B>(2)>;
+
+} // namespace detail
+
+// Maps coordinates in convention From to convention To
+template <typename From, typename To>
+using Conversion = detail::Compose<detail::Inverse<typename To::ToRos>, typename From::ToRos>;
+
+template <typename A, typename B>
+constexpr bool samePermutation() {
+    return A::row(0) == B::row(0) && A::row(1) == B::row(1) && A::row(2) == B::row(2);
+}
+
+// The mapping previously hand-written in vive_node: (x, y, z) -> (-z, -x, y)
+static_assert(samePermutation<Conversion<SteamVR, Ros>, SignedPermutation<-3, -1, 2>>(), "SteamVR to ROS");
+static_assert(samePermutation<Conversion<Ros, SteamVR>, SignedPermutation<-2, 3, -1>>(), "ROS to SteamVR");
+static_assert(samePermutation<Conversion<SteamVR, Unity>, SignedPermutation<1, 2, -3>>(), "SteamVR to Unity");
+static_assert(samePermutation<Conversion<Ros, Ros>, SignedPermutation<1, 2, 3>>(), "identity");
+static_assert(samePermutation<detail::Compose<Conversion<Ros, SteamVR>, Conversion<SteamVR, Ros>>, SignedPermutation<1, 2, 3>>(),
+              "round trip");
+static_assert(Conversion<SteamVR, Ros>::determinant() == 1, "SteamVR and ROS are both right-handed");
+static_assert(Conversion<SteamVR, Unity>::determinant() == -1, "Unity is left-handed");
+
+} // namespace axis
+
+#endif // AXIS_CONVENTION_HPP
@@ -0,0 +1,56 @@
+#ifndef CALIBRATION_HPP
+#define CALIBRATION_HPP
+
+#include <functional>
+#include <map>
+#include <string>
+#include <openvr.h>
+
+#include "transform.hpp"
+
+// Fused calibration of one device: world <- universe and device <- tool tip.
+// Poses stay in SteamVR axis convention (y up), only the origin, heading and
+// tool point change.
+struct CalibrationTransform {
+    transform::RigidTransform<float> world;    // world from tracking universe
+    transform::RigidTransform<float> tool;     // device from tool tip
+    bool identity = true;
+
+    // pose = world * pose * tool, velocities of the tool tip in world axes
+    void apply(vr::TrackedDevicePose_t& pose) const;
+};
+
+// Per-device calibration loaded from a JSON file:
+// {
+//   "world": {"translation": [x, y, z], "rotation": [qx, qy, qz, qw]},
+//   "tool":  {"translation": [x, y, z], "rotation": [qx, qy, qz, qw]},
+//   "devices": {
+//     "<serial number or device index>": {"world": {...}, "tool": {...}}
+//   }
+// }
+// Top level transforms are the defaults, omitted transforms are identity.
+class Calibration {
+public:
+    // Replaces the calibration, keeps the previous one and returns false on error
+    bool load(const std::string& path);
+    const std::string& path() const { return file_path; }
+
+    // Precomputed transforms of a device, done once when it connects.
+    // Without the tool offset for devices that carry no tool (base stations).
+    // Empty serial to look up the device index only.
+    CalibrationTransform resolve(vr::TrackedDeviceIndex_t index, const char* serial, bool with_tool = true) const;
+
+private:
+    struct Entry {
+        transform::RigidTransform<float> world = transform::RigidTransform<float>::identity();
+        transform::RigidTransform<float> tool = transform::RigidTransform<float>::identity();
+        bool has_world = false;
+        bool has_tool = false;
+    };
+
+    std::string file_path;
+    Entry defaults;
+    std::map<std::string, Entry, std::less<>> devices;
+};
+
+#endif // CALIBRATION_HPP
@@ -0,0 +1,56 @@
+#ifndef CONFIG_RELOADER_HPP
+#define CONFIG_RELOADER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "calibration.hpp"
+#include "pose_filter.hpp"
+
+// Reloads the calibration and filter files on request (SIGHUP) on its own
+// thread, so file I/O and JSON parsing never stall the VR loop. The VR
+// thread picks up a finished reload with apply(), which only swaps the
+// loaded configuration with the one in use; the old one is freed here.
+class ConfigReloader {
+public:
+    // Empty paths are not reloaded
+    ConfigReloader(std::atomic<bool>& requested, const std::string& calibration_path, const std::string& filter_path,
+                   std::chrono::milliseconds period = std::chrono::milliseconds(100));
+    ~ConfigReloader();
+
+    void start();
+    void stop();
+
+    struct Applied {
+        bool calibration = false;
+        bool filter = false;
+    };
+    // Called on the VR thread, swaps in whatever was loaded since the last call
+    Applied apply(Calibration* calibration, PoseFilterConfig* filter);
+
+private:
+    std::atomic<bool>& requested;
+    std::string calibration_path;
+    std::string filter_path;
+    std::chrono::milliseconds period;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool running = false;
+
+    // Loaded on the reloader thread, guarded by mutex until handed over
+    Calibration loaded_calibration;
+    PoseFilterConfig loaded_filter;
+    std::atomic<bool> calibration_ready{false};
+    std::atomic<bool> filter_ready{false};
+
+    void run();
+    void reload();
+};
+
+#endif // CONFIG_RELOADER_HPP
@@ -0,0 +1,45 @@
+#ifndef DEAD_RECKONING_HPP
+#define DEAD_RECKONING_HPP
+
+#include <cstdint>
+#include <openvr.h>
+
+#include "transform.hpp"
+
+// Bounded dead reckoning of one device through short tracking dropouts.
+// While the pose is invalid or out of range, the last tracked pose is
+// extrapolated with its linear and angular velocity for at most a window;
+// when tracking returns, the offset between the prediction and the
+// measurement is faded out over the same window instead of jumping.
+// Fixed-size state, one per device index.
+class DeadReckoning {
+public:
+    enum Result {
+        Tracked,    // measured pose, possibly blended back from a prediction
+        Predicted,  // pose replaced by the extrapolation
+        Lost        // dropout longer than the window, or nothing to extrapolate from
+    };
+
+    // pose in the published frame; rewritten when predicted or blending
+    Result update(int64_t time_ns, int64_t window_ns, vr::TrackedDevicePose_t& pose);
+    void reset();
+
+private:
+    bool has_last = false;
+    int64_t last_time_ns = 0;
+    transform::Vector3<float> position{0.0f, 0.0f, 0.0f};
+    transform::Quaternion<float> orientation = transform::Quaternion<float>::identity();
+    transform::Vector3<float> velocity{0.0f, 0.0f, 0.0f};
+    transform::Vector3<float> angular_velocity{0.0f, 0.0f, 0.0f};
+
+    bool predicting = false;
+    transform::Vector3<float> predicted_position{0.0f, 0.0f, 0.0f};
+    transform::Quaternion<float> predicted_orientation = transform::Quaternion<float>::identity();
+
+    // Prediction minus measurement when tracking returned, faded out from blend_start_ns
+    int64_t blend_start_ns = -1;
+    transform::Vector3<float> blend_position{0.0f, 0.0f, 0.0f};
+    transform::Quaternion<float> blend_orientation = transform::Quaternion<float>::identity();
+};
+
+#endif // DEAD_RECKONING_HPP
@@ -0,0 +1,41 @@
+#ifndef DEVICE_METADATA_HPP
+#define DEVICE_METADATA_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <openvr.h>
+
+#include "seqlock.hpp"
+
+// Slowly changing device properties, kept out of the VR loop
+struct DeviceMetadata {
+    bool connected;
+    bool provides_battery;
+    bool charging;
+    uint8_t device_class;       // vr::ETrackedDeviceClass
+    float battery;              // 0..1
+    char serial[32];
+    char model[48];
+    char firmware[48];
+};
+
+// Latest metadata per device index, written by the property poller and read
+// lock-free by the server
+class DeviceMetadataTable {
+public:
+    void store(vr::TrackedDeviceIndex_t i, const DeviceMetadata& metadata) {
+        entries[i].store(metadata);
+        changes.fetch_add(1, std::memory_order_release);
+    }
+    // Version of the entry, 0 if the device was never seen
+    uint64_t load(vr::TrackedDeviceIndex_t i, DeviceMetadata& metadata) const { return entries[i].load(metadata); }
+    uint64_t version(vr::TrackedDeviceIndex_t i) const { return entries[i].version(); }
+    // Bumped on every store, to check for changes without scanning the table
+    uint64_t changeCount() const { return changes.load(std::memory_order_acquire); }
+
+private:
+    SeqLock<DeviceMetadata> entries[vr::k_unMaxTrackedDeviceCount];
+    std::atomic<uint64_t> changes{0};
+};
+
+#endif // DEVICE_METADATA_HPP
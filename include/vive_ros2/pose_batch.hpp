@@ -0,0 +1,64 @@
+#ifndef POSE_BATCH_HPP
+#define POSE_BATCH_HPP
+
+#include <cstdint>
+#include <openvr.h>
+
+#include "transform.hpp"
+
+enum PoseBatchFlags : uint8_t {
+    BatchHasInput = 1 << 0,
+    BatchPredicted = 1 << 1,    // dead-reckoned pose
+    BatchRejected = 1 << 2      // failed the jump check, not published
+};
+
+// The tracker poses to publish in one poll iteration, transposed from the
+// OpenVR pose array into one array per field. Only active devices are
+// stored, so the per-sample math runs as plain loops over contiguous data
+// instead of strided reads and a branch per device slot.
+//
+// The orientation is converted while the entry is filled, per device and in
+// double precision like GetQuaternion(). A separate float SIMD pass over a
+// copy of the rotation matrices cost more in copying than it saved for any
+// device count (vive_pose_benchmark).
+struct PoseBatch {
+    static constexpr uint32_t kCapacity = vr::k_unMaxTrackedDeviceCount;
+
+    // Single precision like the OpenVR poses
+    uint32_t count = 0;
+    uint32_t device[kCapacity];            // tracked device index
+    uint8_t flags[kCapacity];              // PoseBatchFlags
+    float position[3][kCapacity];
+    double orientation[4][kCapacity];      // w, x, y, z
+    float velocity[3][kCapacity];
+    float angular_velocity[3][kCapacity];
+
+    void clear() { count = 0; }
+    // Inline, called per device from the acquisition loop
+    void add(vr::TrackedDeviceIndex_t i, const vr::TrackedDevicePose_t& pose, uint8_t entry_flags) {
+        if (count >= kCapacity) {
+            return;
+        }
+        uint32_t k = count;
+        const vr::HmdMatrix34_t& m = pose.mDeviceToAbsoluteTracking;
+        transform::quaternionFromRotation<double>(m.m[0][0], m.m[0][1], m.m[0][2],
+                                                  m.m[1][0], m.m[1][1], m.m[1][2],
+                                                  m.m[2][0], m.m[2][1], m.m[2][2],
+                                                  orientation[0][k], orientation[1][k], orientation[2][k], orientation[3][k]);
+        for (int row = 0; row < 3; row++) {
+            position[row][k] = m.m[row][3];
+            velocity[row][k] = pose.vVelocity.v[row];
+            angular_velocity[row][k] = pose.vAngularVelocity.v[row];
+        }
+        device[k] = i;
+        flags[k] = entry_flags;
+        count = k + 1;
+    }
+    transform::Quaternion<double> quaternion(uint32_t k) const {
+        return {orientation[0][k], orientation[1][k], orientation[2][k], orientation[3][k]};
+    }
+    // Roll, pitch, yaw in radians, computed on each call; only the debug log uses them
+    transform::EulerXYZ<double> euler(uint32_t k) const { return quaternion(k).toEulerXYZ(); }
+};
+
+#endif // POSE_BATCH_HPP
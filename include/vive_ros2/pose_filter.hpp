@@ -0,0 +1,57 @@
+#ifndef POSE_FILTER_HPP
+#define POSE_FILTER_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "transform.hpp"
+
+// One-Euro filter parameters (Casiez et al. 2012): the cutoff frequency
+// rises with the filtered speed, min_cutoff + beta * |speed|, so jitter at
+// rest is smoothed hard while fast motions keep little lag.
+struct OneEuroParams {
+    double min_cutoff = 1.0;    // Hz, cutoff at rest
+    double beta = 0.0;          // Hz per m/s (position) or per rad/s (rotation)
+    double d_cutoff = 1.0;      // Hz, cutoff of the speed estimate
+};
+
+// Filter parameters loaded from a JSON file, reloaded on SIGHUP:
+// {
+//   "position": {"min_cutoff": 1.0, "beta": 0.5, "d_cutoff": 1.0},
+//   "rotation": {"min_cutoff": 1.0, "beta": 0.2, "d_cutoff": 1.0}
+// }
+// Omitted values keep their defaults.
+class PoseFilterConfig {
+public:
+    // Replaces the parameters, keeps the previous ones and returns false on error
+    bool load(const std::string& path);
+    const std::string& path() const { return file_path; }
+
+    OneEuroParams position;
+    OneEuroParams rotation;
+
+private:
+    std::string file_path;
+};
+
+// One-Euro state of one device, fixed size and allocation free. The
+// parameters are passed on every call so a reload applies immediately
+// without resetting the state.
+class PoseFilter {
+public:
+    void reset() { initialized = false; }
+
+    // Smooths position and orientation in place; the first sample after a reset passes through
+    void filter(const PoseFilterConfig& config, int64_t time_ns,
+                transform::Vector3<double>& position, transform::Quaternion<double>& orientation);
+
+private:
+    bool initialized = false;
+    int64_t last_time_ns = 0;
+    transform::Vector3<double> position_{0.0, 0.0, 0.0};
+    transform::Vector3<double> velocity{0.0, 0.0, 0.0};
+    transform::Quaternion<double> orientation_ = transform::Quaternion<double>::identity();
+    double angular_speed = 0.0;
+};
+
+#endif // POSE_FILTER_HPP
@@ -0,0 +1,63 @@
+#ifndef POSE_HISTORY_HPP
+#define POSE_HISTORY_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "transform.hpp"
+
+// Pose of a device at one instant, in the frame of the caller
+struct TimedPose {
+    int64_t time_ns;
+    transform::Vector3<double> position;
+    transform::Quaternion<double> orientation;
+};
+
+// Per-device ring buffers of timestamped poses, for looking up the pose of
+// a tracker at the timestamp of another sensor. Lookups are a binary
+// search plus lerp/slerp between the two neighbouring samples; past either
+// end of the history the pose is extrapolated for at most
+// max_extrapolation_ns. Safe to add and look up from different threads.
+class PoseHistory {
+public:
+    enum Result {
+        Interpolated,
+        Extrapolated,
+        TooOld,         // before the oldest sample by more than the extrapolation limit
+        TooNew,         // after the newest sample by more than the extrapolation limit
+        NoData          // nothing recorded for this device
+    };
+
+    static constexpr uint32_t kMaxDevices = 64;
+
+    explicit PoseHistory(size_t capacity = 2048, int64_t max_extrapolation_ns = 50000000);
+
+    // Samples must arrive in time order per device, others are dropped
+    bool add(uint32_t device, const TimedPose& pose);
+    Result lookup(uint32_t device, int64_t time_ns, TimedPose& pose) const;
+
+    // Time span held for a device, false if it has no samples
+    bool range(uint32_t device, int64_t& oldest_ns, int64_t& newest_ns) const;
+    void clear(uint32_t device);
+
+    static const char* resultName(Result result);
+
+private:
+    struct Ring {
+        std::vector<TimedPose> samples;  // allocated on the first sample
+        size_t head = 0;                 // index of the oldest sample
+        size_t count = 0;
+
+        const TimedPose& at(size_t k) const { return samples[(head + k) % samples.size()]; }
+    };
+
+    static TimedPose interpolate(const TimedPose& a, const TimedPose& b, int64_t time_ns);
+
+    size_t capacity;
+    int64_t max_extrapolation_ns;
+    mutable std::mutex mutex;
+    Ring rings[kMaxDevices];
+};
+
+#endif // POSE_HISTORY_HPP
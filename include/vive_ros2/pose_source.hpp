@@ -0,0 +1,74 @@
+#ifndef POSE_SOURCE_HPP
+#define POSE_SOURCE_HPP
+
+#include <atomic>
+#include <shared_mutex>
+#include <openvr.h>
+
+#include "device_metadata.hpp"
+
+// Where ViveInput gets its samples from. The OpenVR types are used as the
+// common vocabulary so every source looks like IVRSystem to the loop.
+class PoseSource {
+public:
+    virtual ~PoseSource() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool init() = 0;
+    virtual void shutdown() = 0;
+    // True if a failed init() may succeed later, e.g. a runtime that is not up yet
+    virtual bool recoverable() const { return false; }
+    // Checked every iteration after getPoses(), false once the connection is lost.
+    // Must not block; slow liveness checks belong in probe().
+    virtual bool healthy() { return true; }
+    // Liveness check of the connection, called from the property poller thread
+    virtual void probe() {}
+
+    // Sample the poses of devices [0, count)
+    virtual void getPoses(vr::TrackedDevicePose_t* poses, uint32_t count) = 0;
+    virtual vr::ETrackedDeviceClass getDeviceClass(vr::TrackedDeviceIndex_t i) = 0;
+    virtual vr::ETrackedControllerRole getControllerRole(vr::TrackedDeviceIndex_t i) = 0;
+    // Input state and pose of the same instant, false if the device has no input
+    virtual bool getControllerStateWithPose(vr::TrackedDeviceIndex_t i, vr::VRControllerState_t* state, vr::TrackedDevicePose_t* pose) = 0;
+    virtual bool pollNextEvent(vr::VREvent_t* event) = 0;
+    // Slow property queries, called from the property poller thread; false if there is no such device
+    virtual bool getDeviceMetadata(vr::TrackedDeviceIndex_t, DeviceMetadata&) { return false; }
+    // True if getDeviceMetadata() reports connected devices, so their serial numbers become known
+    virtual bool providesMetadata() const { return false; }
+
+    // True if getPoses blocks until the next sample is due, so the loop must not add its own period
+    virtual bool pacesItself() const { return false; }
+    // True once the source has nothing more to deliver
+    virtual bool finished() const { return false; }
+};
+
+// Live data from the SteamVR runtime
+class OpenVRPoseSource : public PoseSource {
+public:
+    ~OpenVRPoseSource() override;
+
+    const char* name() const override { return "OpenVR"; }
+    bool init() override;
+    void shutdown() override;
+    bool recoverable() const override { return true; }
+    bool healthy() override { return !lost.load(std::memory_order_relaxed); }
+    void probe() override;
+
+    void getPoses(vr::TrackedDevicePose_t* poses, uint32_t count) override;
+    vr::ETrackedDeviceClass getDeviceClass(vr::TrackedDeviceIndex_t i) override;
+    vr::ETrackedControllerRole getControllerRole(vr::TrackedDeviceIndex_t i) override;
+    bool getControllerStateWithPose(vr::TrackedDeviceIndex_t i, vr::VRControllerState_t* state, vr::TrackedDevicePose_t* pose) override;
+    bool pollNextEvent(vr::VREvent_t* event) override;
+    bool getDeviceMetadata(vr::TrackedDeviceIndex_t i, DeviceMetadata& metadata) override;
+    bool providesMetadata() const override { return true; }
+
+private:
+    // The VR thread owns pHMD; the property poller reads it under a shared lock
+    // while init() and shutdown() replace it
+    std::shared_mutex runtime_mutex;
+    vr::IVRSystem *pHMD = nullptr;
+    vr::EVRInitError eError = vr::VRInitError_None;
+    std::atomic<bool> lost{false};  // set by VREvent_Quit or a failed probe()
+};
+
+#endif // POSE_SOURCE_HPP
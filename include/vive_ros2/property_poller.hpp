@@ -0,0 +1,41 @@
+#ifndef PROPERTY_POLLER_HPP
+#define PROPERTY_POLLER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "device_metadata.hpp"
+#include "pose_source.hpp"
+
+// Refreshes device properties (battery, serial, model, firmware) and runs
+// the source's liveness probe at a low rate on its own thread, so the VR
+// loop never waits on property queries
+class PropertyPoller {
+public:
+    PropertyPoller(PoseSource& source, DeviceMetadataTable& table, std::chrono::milliseconds period = std::chrono::seconds(1));
+    ~PropertyPoller();
+
+    // Called on the poller thread after a refresh that changed the table
+    void setChangeCallback(std::function<void()> callback) { on_change = std::move(callback); }
+    void start();
+    void stop();
+
+private:
+    PoseSource& source;
+    DeviceMetadataTable& table;
+    std::chrono::milliseconds period;
+    std::function<void()> on_change;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool running = false;
+
+    void run();
+    bool refresh();
+};
+
+#endif // PROPERTY_POLLER_HPP
@@ -0,0 +1,66 @@
+#ifndef REALTIME_HPP
+#define REALTIME_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Optional real-time setup of a thread, everything is off by default
+struct RealtimeConfig {
+    int priority = 0;          // SCHED_FIFO priority (1-99), 0 keeps the default scheduler
+    int cpu = -1;              // CPU to pin the thread to, -1 for no affinity
+    bool check_allocations = false; // report heap allocations on the hot path (VR thread only)
+};
+
+class RealtimeUtils {
+public:
+    // Lock current and future pages of the process into RAM
+    static bool lockMemory();
+
+    // Apply priority and affinity to the calling thread and pre-fault its stack
+    static bool configureThread(const RealtimeConfig& config, const std::string& name);
+
+    // Touch the top of the stack so the hot path does not page fault on it
+    static void prefaultStack();
+
+    // Number of operator new calls made by the calling thread
+    static uint64_t threadAllocationCount();
+};
+
+// Iteration timing of a periodic loop, reported in fixed windows
+class LoopStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LoopStats(const std::string& name, std::chrono::microseconds nominal_period, std::chrono::seconds report_interval);
+
+    void setCheckAllocations(bool enabled) { check_allocations = enabled; }
+
+    // Call once per iteration of the hot path
+    void tick();
+    // Call when the loop leaves the hot path (idle), so the gap is not counted as a stall
+    void pause() { running = false; }
+
+private:
+    std::string name;
+    std::chrono::microseconds nominal_period;
+    std::chrono::seconds report_interval;
+    bool check_allocations = false;
+
+    bool running = false;
+    bool warmed_up = false;
+    Clock::time_point last_tick;
+    Clock::time_point window_start;
+    uint64_t last_allocations = 0;
+
+    // Current window
+    uint64_t iterations = 0;
+    uint64_t stalls = 0;
+    uint64_t allocations = 0;
+    double sum_us = 0.0;
+    double max_us = 0.0;
+
+    void report(Clock::time_point now);
+};
+
+#endif // REALTIME_HPP
@@ -0,0 +1,142 @@
+#ifndef RECORDER_HPP
+#define RECORDER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <openvr.h>
+
+// On-disk layout of a vive_input recording:
+//   [RecordingHeader, padded to kRecordingHeaderSize][RecordedSample ...]
+// Samples are grouped in chunks of header.chunk_records consecutive samples,
+// header.chunks[] indexes them by record number and time for seeking.
+
+constexpr char kRecordingMagic[8] = {'V', 'I', 'V', 'E', 'R', 'E', 'C', '1'};
+constexpr uint32_t kRecordingVersion = 1;
+constexpr size_t kRecordingHeaderSize = 64 * 1024;
+
+enum RecordedSampleFlags : uint8_t {
+    SampleConnected = 1 << 0,
+    SamplePoseValid = 1 << 1,
+    SampleHasInput  = 1 << 2
+};
+
+// One device in one poll iteration, raw as delivered by the pose source
+struct RecordedSample {
+    int64_t time_ns;            // steady clock at the poll
+    uint32_t frame;             // poll iteration, shared by the devices of one snapshot
+    uint8_t device;             // tracked device index
+    uint8_t device_class;       // vr::ETrackedDeviceClass
+    uint8_t role;               // vr::ETrackedControllerRole
+    uint8_t flags;              // RecordedSampleFlags
+    uint16_t tracking_result;   // vr::ETrackingResult
+    uint16_t reserved0;
+    float matrix[3][4];         // mDeviceToAbsoluteTracking
+    float velocity[3];
+    float angular_velocity[3];
+    uint32_t reserved1;
+    uint64_t buttons_pressed;
+    uint64_t buttons_touched;
+    float trackpad[2];
+    float trigger;
+    uint32_t reserved2;
+};
+static_assert(sizeof(RecordedSample) == 128, "RecordedSample layout is part of the file format");
+
+struct RecordingChunk {
+    uint64_t first_record;
+    int64_t first_time_ns;
+    int64_t last_time_ns;
+    uint32_t record_count;
+    uint32_t reserved;
+};
+
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint32_t chunk_records;
+    uint32_t max_chunks;
+    uint32_t chunk_count;
+    uint64_t record_count;
+    int64_t start_wall_ns;      // system clock when recording started
+    int64_t start_time_ns;      // steady clock when recording started
+    uint8_t reserved[64];
+    RecordingChunk chunks[1];   // max_chunks entries, up to kRecordingHeaderSize
+};
+
+constexpr uint32_t kRecordingMaxChunks =
+    (kRecordingHeaderSize - offsetof(RecordingHeader, chunks)) / sizeof(RecordingChunk);
+
+// Appends samples to a preallocated memory-mapped file. The acquisition
+// thread writes each sample in place (beginSample/commitSample), so the
+// hot path is a few stores and no system calls. A helper thread notices
+// each new chunk and starts write-back of the finished one and read-ahead
+// of the next, which may block on a congested disk.
+class Recorder {
+public:
+    Recorder() = default;
+    ~Recorder();
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    bool open(const std::string& path, size_t max_bytes);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    // Slot for the next sample, nullptr when the file is full
+    RecordedSample* beginSample();
+    void commitSample();
+
+    // Fill and commit a sample from a pose and an optional input state
+    void record(int64_t time_ns, uint32_t frame, vr::TrackedDeviceIndex_t device, vr::ETrackedDeviceClass device_class,
+                vr::ETrackedControllerRole role, const vr::TrackedDevicePose_t& pose, const vr::VRControllerState_t* state);
+
+    uint64_t recordCount() const { return header ? header->record_count : 0; }
+
+private:
+    int fd = -1;
+    size_t mapped_size = 0;
+    uint8_t* mapping = nullptr;
+    RecordingHeader* header = nullptr;
+    RecordedSample* samples = nullptr;
+    uint64_t capacity = 0;
+    bool full_reported = false;
+    std::string path;
+
+    std::atomic<uint32_t> chunks_started{0};  // published by commitSample()
+    std::atomic<bool> writeback_running{false};
+    std::thread writeback;
+    void writebackLoop();
+};
+
+// Read-only view of a recording, tolerant of files that were not closed
+// (record_count is clamped to what the file actually holds)
+class RecordingReader {
+public:
+    RecordingReader() = default;
+    ~RecordingReader();
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const RecordingHeader& header() const { return *header_; }
+    const RecordedSample* samples() const { return samples_; }
+    uint64_t count() const { return count_; }
+    // Index of the first sample at or after time_ns, count() if none
+    uint64_t findTime(int64_t time_ns) const;
+
+private:
+    size_t mapped_size = 0;
+    uint8_t* mapping = nullptr;
+    const RecordingHeader* header_ = nullptr;
+    const RecordedSample* samples_ = nullptr;
+    uint64_t count_ = 0;
+};
+
+#endif // RECORDER_HPP
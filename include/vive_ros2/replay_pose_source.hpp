@@ -0,0 +1,61 @@
+#ifndef REPLAY_POSE_SOURCE_HPP
+#define REPLAY_POSE_SOURCE_HPP
+
+#include <chrono>
+#include <string>
+
+#include "pose_source.hpp"
+#include "recorder.hpp"
+
+struct ReplayConfig {
+    std::string path;
+    double speed = 1.0;     // playback speed factor, 0 = as fast as possible
+    double seek = 0.0;      // s from the start of the recording
+    bool loop = false;      // each wrap-around reports one frame without devices
+};
+
+// Plays a recording back frame by frame with the original timing (scaled),
+// so it goes through the same ViveInput, Server and vive_node code as live data
+class ReplayPoseSource : public PoseSource {
+public:
+    explicit ReplayPoseSource(const ReplayConfig& config);
+
+    const char* name() const override { return "replay"; }
+    bool init() override;
+    void shutdown() override;
+
+    void getPoses(vr::TrackedDevicePose_t* poses, uint32_t count) override;
+    vr::ETrackedDeviceClass getDeviceClass(vr::TrackedDeviceIndex_t i) override;
+    vr::ETrackedControllerRole getControllerRole(vr::TrackedDeviceIndex_t i) override;
+    bool getControllerStateWithPose(vr::TrackedDeviceIndex_t i, vr::VRControllerState_t* state, vr::TrackedDevicePose_t* pose) override;
+    bool pollNextEvent(vr::VREvent_t* event) override;
+    bool pacesItself() const override { return true; }
+    bool finished() const override { return done; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    ReplayConfig config;
+    RecordingReader reader;
+    uint64_t first = 0;         // record to start (and loop) from
+    uint64_t cursor = 0;
+    bool done = false;
+
+    // Wall time at which the sample time base_time_ns is played
+    Clock::time_point base_wall;
+    int64_t base_time_ns = 0;
+
+    Clock::time_point started;
+    uint64_t frames = 0;
+    uint64_t samples = 0;
+
+    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+    vr::VRControllerState_t states[vr::k_unMaxTrackedDeviceCount];
+    uint8_t device_class[vr::k_unMaxTrackedDeviceCount] = {};
+    uint8_t role[vr::k_unMaxTrackedDeviceCount] = {};
+    bool has_input[vr::k_unMaxTrackedDeviceCount] = {};
+
+    void rewind();
+};
+
+#endif // REPLAY_POSE_SOURCE_HPP
@@ -0,0 +1,66 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+// Single-writer, multi-reader sequence lock. The writer never blocks and
+// readers retry while a write is in progress. The payload is kept in
+// relaxed atomic words so concurrent access is well defined.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    SeqLock() {
+        for (auto& word : words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Writer side, returns the new version
+    uint64_t store(const T& value) {
+        uint64_t buffer[kWords] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; i++) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+        return seq + 2;
+    }
+
+    // Consistent snapshot and its version, 0 if never written
+    uint64_t load(T& value) const {
+        uint64_t buffer[kWords];
+        while (true) {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < kWords; i++) {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                std::memcpy(&value, buffer, sizeof(T));
+                return before;
+            }
+        }
+    }
+
+    uint64_t version() const { return sequence.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> words[kWords];
+};
+
+#endif // SEQLOCK_HPP
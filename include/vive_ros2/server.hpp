@@ -1,7 +1,9 @@
 #ifndef SERVER_HPP
 #define SERVER_HPP
 
+#include <atomic>
 #include <thread>
+#include <chrono>
 #include <mutex>
 #include <condition_variable>
 #include <sys/socket.h>
@@ -11,6 +13,9 @@
 
 #include "json.hpp"
 #include "VRUtils.hpp"
+#include "realtime.hpp"
+#include "device_metadata.hpp"
+#include "tracking_stats.hpp"
 
 using json = nlohmann::json;
 
@@ -22,24 +27,91 @@ private:
 
     std::mutex &data_mutex;
     std::condition_variable &data_cv;
-    VRControllerData &shared_data;
+    TrackerSampleSlots &shared_samples;
+    RealtimeConfig rt_config;
+    std::chrono::microseconds expected_period{5000};
+    bool running = true; // guarded by data_mutex
 
-    json prepareData();
+    // Base station channel, guarded by data_mutex
+    TrackingReferenceData references[vr::k_unMaxTrackedDeviceCount];
+    uint64_t known_references = 0;      // bit per device index
+    uint64_t pending_references = 0;
+
+    // Relative poses, the latest per tool device index, guarded by data_mutex
+    RelativePoseData relative_poses[vr::k_unMaxTrackedDeviceCount];
+    uint64_t pending_relative = 0;
+
+    // Pose source status, sent on change and to new clients
+    bool status_known = false;
+    bool status_available = false;
+    bool pending_status = false;
+    std::string status_source;
+
+    // Tracking quality of the last window
+    TrackingQuality tracking_quality[vr::k_unMaxTrackedDeviceCount];
+    uint32_t tracking_quality_count = 0;
+    double tracking_quality_window = 0.0;
+    bool pending_quality = false;
+
+    // Device metadata channel, sent on change
+    const DeviceMetadataTable *metadata = nullptr;
+    uint64_t sent_metadata_changes = 0;
+    uint64_t sent_metadata_version[vr::k_unMaxTrackedDeviceCount] = {};
+
+    bool prepareMessages(std::string &out);
+    void appendTrackerMessage(const VRControllerData &data, std::string &out);
+    void appendReferenceMessage(const TrackingReferenceData &data, std::string &out);
+    void appendRelativeMessage(const RelativePoseData &data, std::string &out);
+    void appendMetadataMessages(std::string &out);
+    void appendStatusMessage(std::string &out);
+    void appendQualityMessage(std::string &out);
 
     static void signalHandler(int signum) {
         std::cout << "Interrupt signal (" << signum << ") received.\n";
-        exit(signum);   // terminate program
+        if (stopRequested().exchange(true)) {
+            exit(signum);   // second signal, terminate program
+        }
+    }
+    static void reloadHandler(int) {
+        reloadRequested().store(true);
     }
 
 public:
-    Server(int port, std::mutex &mutex, std::condition_variable &cv, VRControllerData &data);
+    Server(int port, std::mutex &mutex, std::condition_variable &cv, TrackerSampleSlots &samples);
     ~Server();
 
+    void setRealtimeConfig(const RealtimeConfig &config) { rt_config = config; }
+    void setExpectedPeriod(std::chrono::microseconds period) { expected_period = period; }
     void start();
+    void stop();
+    // Queue a base station update for the clients, called from the VR thread
+    void publishTrackingReference(const TrackingReferenceData &data);
+    // Queue the relative poses of one poll, called from the VR thread
+    void publishRelativePoses(const RelativePoseData *poses, uint32_t count);
+    // Clients stay connected while the pose source is unavailable and get a status message instead
+    void publishStatus(const char *source, bool available);
+    // Copies the window results, no allocation on the calling (VR) thread
+    void publishTrackingQuality(const TrackingQuality *results, uint32_t count, double window);
+    void setDeviceMetadata(const DeviceMetadataTable *table) { metadata = table; }
+    // Wake up the server after the metadata table changed
+    void notifyDeviceMetadata();
     static std::string getCurrentTimeWithMilliseconds();
+    // Set by SIGINT/SIGTERM, the VR loop polls it to shut down cleanly
+    static std::atomic<bool> &stopRequested() {
+        static std::atomic<bool> requested(false);
+        return requested;
+    }
+    // Set by SIGHUP, the VR loop reloads its configuration
+    static std::atomic<bool> &reloadRequested() {
+        static std::atomic<bool> requested(false);
+        return requested;
+    }
     static void setupSignalHandlers() {
+        stopRequested();
+        reloadRequested();
         signal(SIGINT, signalHandler);
         signal(SIGTERM, signalHandler);
+        signal(SIGHUP, reloadHandler);
     }
 };
 
@@ -0,0 +1,63 @@
+#ifndef SYNTHETIC_POSE_SOURCE_HPP
+#define SYNTHETIC_POSE_SOURCE_HPP
+
+#include <chrono>
+#include <random>
+#include <string>
+
+#include "pose_source.hpp"
+
+struct SyntheticConfig {
+    enum Trajectory { Static, Circle, Figure8 };
+
+    uint32_t devices = 1;            // generic trackers at indices [0, devices)
+    uint32_t references = 0;         // base stations after the trackers
+    Trajectory trajectory = Circle;
+    double radius = 0.2;             // m
+    double frequency = 0.5;          // trajectory revolutions per second
+    double position_noise = 0.0;     // standard deviation, m
+    double rotation_noise = 0.0;     // standard deviation, rad
+    double dropout_rate = 0.0;       // dropouts per second and device
+    double dropout_duration = 0.05;  // s
+    unsigned seed = 1;
+
+    static bool parseTrajectory(const std::string& name, Trajectory& trajectory);
+};
+
+// Generates tracker poses without SteamVR or hardware, for load tests and CI
+class SyntheticPoseSource : public PoseSource {
+public:
+    explicit SyntheticPoseSource(const SyntheticConfig& config);
+
+    const char* name() const override { return "synthetic"; }
+    bool init() override;
+    void shutdown() override {}
+
+    void getPoses(vr::TrackedDevicePose_t* poses, uint32_t count) override;
+    vr::ETrackedDeviceClass getDeviceClass(vr::TrackedDeviceIndex_t i) override;
+    vr::ETrackedControllerRole getControllerRole(vr::TrackedDeviceIndex_t i) override;
+    bool getControllerStateWithPose(vr::TrackedDeviceIndex_t i, vr::VRControllerState_t* state, vr::TrackedDevicePose_t* pose) override;
+    bool pollNextEvent(vr::VREvent_t* event) override;
+    bool getDeviceMetadata(vr::TrackedDeviceIndex_t i, DeviceMetadata& metadata) override;
+    bool providesMetadata() const override { return true; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    SyntheticConfig config;
+    Clock::time_point start_time;
+    double last_sample_time = 0.0;
+    double sample_time = 0.0;
+
+    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+    double dropout_until[vr::k_unMaxTrackedDeviceCount] = {};
+
+    std::mt19937 rng;
+    std::normal_distribution<double> gaussian{0.0, 1.0};
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+
+    void generate(uint32_t i, double t, double dt);
+    void generateReference(uint32_t i);
+};
+
+#endif // SYNTHETIC_POSE_SOURCE_HPP
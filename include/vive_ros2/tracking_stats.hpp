@@ -0,0 +1,67 @@
+#ifndef TRACKING_STATS_HPP
+#define TRACKING_STATS_HPP
+
+#include <cstdint>
+#include <openvr.h>
+
+// Buckets for vr::ETrackingResult, plus poses flagged invalid while the
+// result claims Running_OK
+enum TrackingState {
+    StateUninitialized,
+    StateCalibrating,
+    StateCalibratingOutOfRange,
+    StateRunningOK,
+    StateRunningOutOfRange,
+    StateRotationOnly,
+    StateInvalidPose,
+    kTrackingStateCount
+};
+
+const char* trackingStateName(int state);
+
+// Tracking quality of one device over one window
+struct TrackingQuality {
+    uint32_t index;
+    uint8_t device_class;               // vr::ETrackedDeviceClass
+    uint32_t samples;
+    uint32_t counts[kTrackingStateCount];
+    float durations[kTrackingStateCount];   // s spent in each state
+    float valid_rate;                   // valid poses per second
+    float valid_fraction;               // of the samples
+    float longest_gap;                  // s without a valid pose
+};
+
+// Per-device counters for the acquisition thread, aggregated in fixed
+// windows into preallocated arrays (no allocation per sample or window)
+class TrackingStats {
+public:
+    explicit TrackingStats(int64_t window_ns = 10000000000LL);
+
+    // One sample of a connected device
+    void sample(vr::TrackedDeviceIndex_t i, vr::ETrackedDeviceClass device_class, const vr::TrackedDevicePose_t& pose, int64_t time_ns);
+    // Close the window once it is over, true if results() holds a new window
+    bool endWindow(int64_t time_ns);
+
+    // Devices that were sampled in the last closed window
+    const TrackingQuality* results() const { return results_; }
+    uint32_t resultCount() const { return result_count; }
+    double windowSeconds() const { return window_seconds; }
+    void log() const;
+
+private:
+    struct Device {
+        TrackingQuality current;
+        int state = -1;             // state of the previous sample, -1 if none
+        int64_t last_time_ns = 0;
+        int64_t gap_start_ns = -1;  // start of the running gap, -1 if tracking
+    };
+
+    int64_t window_ns;
+    int64_t window_start_ns = -1;
+    double window_seconds = 0.0;
+    Device devices[vr::k_unMaxTrackedDeviceCount];
+    TrackingQuality results_[vr::k_unMaxTrackedDeviceCount];
+    uint32_t result_count = 0;
+};
+
+#endif // TRACKING_STATS_HPP
@@ -0,0 +1,248 @@
+#ifndef TRANSFORM_HPP
+#define TRANSFORM_HPP
+
+#include <cmath>
+
+// Rigid-body math for float and double: vectors, quaternions, rotation
+// matrices and rigid transforms. Everything that needs no square root or
+// trigonometry is constexpr (checked by the static_asserts at the end);
+// normalization, slerp, axis-angle and Euler angles use <cmath> and are
+// plain inline. Products, rotations and the matrix/quaternion conversions
+// have no data-dependent branches.
+//
+// Quaternions are Hamilton (w, x, y, z), q and -q are the same rotation.
+// Matrices are row-major and act on column vectors.
+
+namespace transform {
+
+template <typename T>
+struct Vector3 {
+    T x, y, z;
+
+    constexpr Vector3 operator+(const Vector3& v) const { return {x + v.x, y + v.y, z + v.z}; }
+    constexpr Vector3 operator-(const Vector3& v) const { return {x - v.x, y - v.y, z - v.z}; }
+    constexpr Vector3 operator-() const { return {-x, -y, -z}; }
+    constexpr Vector3 operator*(T s) const { return {x * s, y * s, z * s}; }
+    constexpr bool operator==(const Vector3& v) const { return x == v.x && y == v.y && z == v.z; }
+
+    constexpr T dot(const Vector3& v) const { return x * v.x + y * v.y + z * v.z; }
+    constexpr Vector3 cross(const Vector3& v) const { return {y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x}; }
+    T norm() const { return std::sqrt(dot(*this)); }
+};
+
+template <typename T>
+struct Matrix3 {
+    T m[3][3];
+
+    static constexpr Matrix3 identity() { return {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}}; }
+
+    constexpr Vector3<T> operator*(const Vector3<T>& v) const {
+        return {m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z};
+    }
+    // Written out so it is straight-line code without relying on unrolling
+    constexpr Matrix3 operator*(const Matrix3& b) const {
+        return {{{product(b, 0, 0), product(b, 0, 1), product(b, 0, 2)},
+                 {product(b, 1, 0), product(b, 1, 1), product(b, 1, 2)},
+                 {product(b, 2, 0), product(b, 2, 1), product(b, 2, 2)}}};
+    }
+    constexpr T product(const Matrix3& b, int r, int c) const {
+        return m[r][0] * b.m[0][c] + m[r][1] * b.m[1][c] + m[r][2] * b.m[2][c];
+    }
+    // The inverse of a rotation
+    constexpr Matrix3 transpose() const {
+        return {{{m[0][0], m[1][0], m[2][0]}, {m[0][1], m[1][1], m[2][1]}, {m[0][2], m[1][2], m[2][2]}}};
+    }
+    constexpr T trace() const { return m[0][0] + m[1][1] + m[2][2]; }
+    constexpr bool operator==(const Matrix3& b) const {
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                if (m[r][c] != b.m[r][c]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+// Shepperd's method: the matrix gives 4 q q^T, and q is taken from the row
+// with the largest diagonal entry (4w^2, 4x^2, 4y^2 or 4z^2), so rotations
+// near 180 degrees keep full precision. The result is normalized, with
+// w >= 0. Scalar arguments so batches in structure-of-arrays form can call
+// it per element; such loops vectorize given -fno-math-errno
+// -fno-trapping-math.
+template <typename T>
+inline void quaternionFromRotation(T m00, T m01, T m02, T m10, T m11, T m12, T m20, T m21, T m22,
+                                   T& w, T& x, T& y, T& z) {
+    T tw = 1 + m00 + m11 + m22;
+    T tx = 1 + m00 - m11 - m22;
+    T ty = 1 - m00 + m11 - m22;
+    T tz = 1 - m00 - m11 + m22;
+    // 4wx, 4wy, 4wz, 4xy, 4xz, 4yz
+    T wx = m21 - m12, wy = m02 - m20, wz = m10 - m01;
+    T xy = m01 + m10, xz = m02 + m20, yz = m12 + m21;
+
+    // Start from the z row and take y, x, w in turn when their diagonal
+    // entry is at least as large; each step is a select, not a branch
+    T t = tz, qw = wz, qx = xz, qy = yz, qz = tz;
+    bool larger = ty >= t;
+    t = larger ? ty : t;
+    qw = larger ? wy : qw; qx = larger ? xy : qx; qy = larger ? ty : qy; qz = larger ? yz : qz;
+    larger = tx >= t;
+    t = larger ? tx : t;
+    qw = larger ? wx : qw; qx = larger ? tx : qx; qy = larger ? xy : qy; qz = larger ? xz : qz;
+    larger = tw >= t;
+    qw = larger ? tw : qw; qx = larger ? wx : qx; qy = larger ? wy : qy; qz = larger ? wz : qz;
+
+    // The row is 4 q_k q; normalizing removes that scale and the error of
+    // a not quite orthonormal matrix
+    T norm2 = qw * qw + qx * qx + qy * qy + qz * qz;
+    T n = 1 / std::sqrt(norm2 > T(1e-30) ? norm2 : T(1e-30));
+    n = std::copysign(n, qw);
+    w = qw * n;
+    x = qx * n;
+    y = qy * n;
+    z = qz * n;
+}
+
+// Intrinsic roll (x), pitch (y), yaw (z) in radians
+template <typename T>
+struct EulerXYZ {
+    T x, y, z;
+};
+
+template <typename T>
+struct Quaternion {
+    T w, x, y, z;
+
+    static constexpr Quaternion identity() { return {1, 0, 0, 0}; }
+
+    // Unit axis, angle in radians
+    static Quaternion fromAxisAngle(const Vector3<T>& axis, T angle) {
+        T s = std::sin(angle / 2);
+        return {std::cos(angle / 2), axis.x * s, axis.y * s, axis.z * s};
+    }
+    static Quaternion fromMatrix(const Matrix3<T>& r) {
+        Quaternion q;
+        quaternionFromRotation(r.m[0][0], r.m[0][1], r.m[0][2], r.m[1][0], r.m[1][1], r.m[1][2],
+                               r.m[2][0], r.m[2][1], r.m[2][2], q.w, q.x, q.y, q.z);
+        return q;
+    }
+
+    constexpr Vector3<T> vec() const { return {x, y, z}; }
+    constexpr T dot(const Quaternion& q) const { return w * q.w + x * q.x + y * q.y + z * q.z; }
+    constexpr T norm2() const { return dot(*this); }
+    // The inverse of a unit quaternion
+    constexpr Quaternion conjugate() const { return {w, -x, -y, -z}; }
+    constexpr Quaternion operator-() const { return {-w, -x, -y, -z}; }
+    constexpr bool operator==(const Quaternion& q) const { return w == q.w && x == q.x && y == q.y && z == q.z; }
+
+    constexpr Quaternion operator*(const Quaternion& q) const {
+        return {w * q.w - x * q.x - y * q.y - z * q.z,
+                w * q.x + x * q.w + y * q.z - z * q.y,
+                w * q.y - x * q.z + y * q.w + z * q.x,
+                w * q.z + x * q.y - y * q.x + z * q.w};
+    }
+
+    // v + 2w (u x v) + 2 u x (u x v), u the vector part
+    constexpr Vector3<T> rotate(const Vector3<T>& v) const {
+        Vector3<T> u = vec();
+        Vector3<T> t = u.cross(v) * T(2);
+        return v + t * w + u.cross(t);
+    }
+
+    constexpr Matrix3<T> toMatrix() const {
+        return {{{1 - 2 * (y * y + z * z), 2 * (x * y - z * w),     2 * (x * z + y * w)},
+                 {2 * (x * y + z * w),     1 - 2 * (x * x + z * z), 2 * (y * z - x * w)},
+                 {2 * (x * z - y * w),     2 * (y * z + x * w),     1 - 2 * (x * x + y * y)}}};
+    }
+
+    Quaternion normalized() const {
+        T n = 1 / std::sqrt(norm2());
+        return {w * n, x * n, y * n, z * n};
+    }
+
+    // Rotation angle in [0, pi] and unit axis, x for the identity
+    T angle() const {
+        T c = std::fabs(w) / std::sqrt(norm2());
+        return 2 * std::acos(c < 1 ? c : T(1));
+    }
+    Vector3<T> axis() const {
+        T s = std::sqrt(x * x + y * y + z * z);
+        T sign = w < 0 ? T(-1) : T(1);
+        return s > T(1e-12) ? Vector3<T>{x, y, z} * (sign / s) : Vector3<T>{1, 0, 0};
+    }
+
+    EulerXYZ<T> toEulerXYZ() const {
+        T sinp = 2 * (w * y - z * x);
+        return {std::atan2(2 * (w * x + y * z), 1 - 2 * (x * x + y * y)),
+                std::asin(sinp > 1 ? T(1) : sinp < -1 ? T(-1) : sinp),  // +-90 degrees when out of range
+                std::atan2(2 * (w * z + x * y), 1 - 2 * (y * y + z * z))};
+    }
+};
+
+// Shortest-path spherical interpolation, t in [0, 1]; falls back to
+// normalized linear interpolation when a and b are nearly equal
+template <typename T>
+Quaternion<T> slerp(const Quaternion<T>& a, const Quaternion<T>& b, T t) {
+    T d = a.dot(b);
+    Quaternion<T> e = d < 0 ? -b : b;
+    d = std::fabs(d);
+    T wa = 1 - t, wb = t;
+    if (d < T(0.9995)) {
+        T theta = std::acos(d);
+        T s = 1 / std::sin(theta);
+        wa = std::sin((1 - t) * theta) * s;
+        wb = std::sin(t * theta) * s;
+    }
+    return Quaternion<T>{wa * a.w + wb * e.w, wa * a.x + wb * e.x, wa * a.y + wb * e.y, wa * a.z + wb * e.z}.normalized();
+}
+
+// x' = rotation * x + translation
+template <typename T>
+struct RigidTransform {
+    Matrix3<T> rotation;
+    Vector3<T> translation;
+
+    static constexpr RigidTransform identity() { return {Matrix3<T>::identity(), {0, 0, 0}}; }
+    static constexpr RigidTransform fromQuaternion(const Quaternion<T>& q, const Vector3<T>& t) { return {q.toMatrix(), t}; }
+
+    constexpr Vector3<T> operator*(const Vector3<T>& p) const { return rotation * p + translation; }
+    // (a * b)(p) = a(b(p))
+    constexpr RigidTransform operator*(const RigidTransform& b) const {
+        return {rotation * b.rotation, rotation * b.translation + translation};
+    }
+    constexpr RigidTransform inverse() const {
+        Matrix3<T> r = rotation.transpose();
+        return {r, -(r * translation)};
+    }
+    constexpr bool operator==(const RigidTransform& b) const { return rotation == b.rotation && translation == b.translation; }
+    constexpr bool isIdentity() const { return *this == identity(); }
+
+    Quaternion<T> orientation() const { return Quaternion<T>::fromMatrix(rotation); }
+};
+
+namespace detail {
+
+// 120 degrees about (1, 1, 1): cycles the axes, exact in binary floating point
+constexpr Quaternion<double> kCycle{0.5, 0.5, 0.5, 0.5};
+constexpr Vector3<double> kX{1, 0, 0}, kY{0, 1, 0}, kZ{0, 0, 1};
+constexpr RigidTransform<double> kPose = RigidTransform<double>::fromQuaternion(kCycle, {1, 2, 3});
+
+static_assert(kCycle.rotate(kX) == kY && kCycle.rotate(kY) == kZ && kCycle.rotate(kZ) == kX, "rotate");
+static_assert(kCycle * kCycle * kCycle == -Quaternion<double>::identity(), "three cycles are a full turn");
+static_assert(kCycle * kCycle.conjugate() == Quaternion<double>::identity(), "conjugate");
+static_assert(kCycle.toMatrix() * kX == kCycle.rotate(kX), "matrix and quaternion agree");
+static_assert((kCycle * kCycle).toMatrix() == kCycle.toMatrix() * kCycle.toMatrix(), "composition order");
+static_assert(kPose * Vector3<double>{0, 0, 0} == Vector3<double>{1, 2, 3}, "translation");
+static_assert(kPose * kX == Vector3<double>{1, 3, 3}, "rotation then translation");
+static_assert((kPose * kPose.inverse()).isIdentity() && (kPose.inverse() * kPose).isIdentity(), "inverse");
+static_assert(kPose.inverse() * (kPose * kY) == kY, "round trip");
+
+} // namespace detail
+
+} // namespace transform
+
+#endif // TRANSFORM_HPP
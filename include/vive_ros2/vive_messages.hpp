@@ -0,0 +1,130 @@
+#ifndef VIVE_MESSAGES_HPP
+#define VIVE_MESSAGES_HPP
+
+#include <string>
+
+#include <builtin_interfaces/msg/time.hpp>
+#include <geometry_msgs/msg/transform_stamped.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+
+#include "VRUtils.hpp"
+#include "axis_convention.hpp"
+#include "vive_ros2/msg/vr_controller_data.hpp"
+
+// The ROS messages vive_node publishes, filled from samples as they come off
+// the wire. Kept free of the node so every output path can be checked on a
+// known pose (test/test_vive_messages.cpp).
+namespace vive_messages {
+
+// vive_input sends SteamVR axes; everything published is REP-103.
+// The conversion happens once, in convertAxes(), right after parsing.
+using WireConvention = axis::SteamVR;
+using OutputConvention = axis::Ros;
+using WireToOutput = axis::Conversion<WireConvention, OutputConvention>;
+
+// The single axis conversion stage, from the wire to the published convention
+inline void convertAxes(VRControllerData& data) {
+    WireToOutput::vector(data.pose_x, data.pose_y, data.pose_z, data.pose_x, data.pose_y, data.pose_z);
+    WireToOutput::quaternion(data.pose_qx, data.pose_qy, data.pose_qz, data.pose_qw,
+                             data.pose_qx, data.pose_qy, data.pose_qz, data.pose_qw);
+    WireToOutput::vector(data.raw_x, data.raw_y, data.raw_z, data.raw_x, data.raw_y, data.raw_z);
+    WireToOutput::quaternion(data.raw_qx, data.raw_qy, data.raw_qz, data.raw_qw,
+                             data.raw_qx, data.raw_qy, data.raw_qz, data.raw_qw);
+    WireToOutput::vector(data.vel_x, data.vel_y, data.vel_z, data.vel_x, data.vel_y, data.vel_z);
+    WireToOutput::pseudovector(data.ang_vel_x, data.ang_vel_y, data.ang_vel_z, data.ang_vel_x, data.ang_vel_y, data.ang_vel_z);
+}
+inline void convertAxes(RelativePoseData& data) {
+    WireToOutput::vector(data.pose_x, data.pose_y, data.pose_z, data.pose_x, data.pose_y, data.pose_z);
+    WireToOutput::quaternion(data.pose_qx, data.pose_qy, data.pose_qz, data.pose_qw,
+                             data.pose_qx, data.pose_qy, data.pose_qz, data.pose_qw);
+}
+inline void convertAxes(TrackingReferenceData& data) {
+    WireToOutput::vector(data.pose_x, data.pose_y, data.pose_z, data.pose_x, data.pose_y, data.pose_z);
+    WireToOutput::quaternion(data.pose_qx, data.pose_qy, data.pose_qz, data.pose_qw,
+                             data.pose_qx, data.pose_qy, data.pose_qz, data.pose_qw);
+}
+
+// Header stamp of a sample from its time_ns, the time base pose_history and
+// the LookupPose service index by
+inline builtin_interfaces::msg::Time stampFromNs(int64_t time_ns) {
+    builtin_interfaces::msg::Time stamp;
+    stamp.sec = static_cast<int32_t>(time_ns / 1000000000);
+    stamp.nanosec = static_cast<uint32_t>(time_ns % 1000000000);
+    return stamp;
+}
+
+// TF frame of a device, by serial number once it is known
+inline std::string trackerFrame(uint32_t device, const std::string& serial) {
+    return "vive_tracker_" + (serial.empty() ? std::to_string(device) : serial);
+}
+
+// TF and vive_pose_abs, world -> frame
+inline void fillTransform(const VRControllerData& pose, const std::string& frame, const builtin_interfaces::msg::Time& stamp,
+                          geometry_msgs::msg::TransformStamped& msg) {
+    msg.header.stamp = stamp;
+    msg.header.frame_id = "world";
+    msg.child_frame_id = frame;
+    msg.transform.translation.x = pose.pose_x;
+    msg.transform.translation.y = pose.pose_y;
+    msg.transform.translation.z = pose.pose_z;
+    msg.transform.rotation.x = pose.pose_qx;
+    msg.transform.rotation.y = pose.pose_qy;
+    msg.transform.rotation.z = pose.pose_qz;
+    msg.transform.rotation.w = pose.pose_qw;
+}
+
+// vive_twist
+inline void fillTwist(const VRControllerData& data, const builtin_interfaces::msg::Time& stamp,
+                      geometry_msgs::msg::TwistStamped& msg) {
+    msg.header.stamp = stamp;
+    msg.header.frame_id = "world";
+    msg.twist.linear.x = data.vel_x;
+    msg.twist.linear.y = data.vel_y;
+    msg.twist.linear.z = data.vel_z;
+    msg.twist.angular.x = data.ang_vel_x;
+    msg.twist.angular.y = data.ang_vel_y;
+    msg.twist.angular.z = data.ang_vel_z;
+}
+
+// tracker_data, one message per device; the poses use the device's frame
+// from trackerFrame(), the raw pose with a _raw suffix
+inline void fillTrackerData(const VRControllerData& data, const std::string& serial, const std::string& time,
+                            const builtin_interfaces::msg::Time& stamp, vive_ros2::msg::VRControllerData& msg) {
+    msg.device = data.device;
+    msg.serial = serial;
+    msg.grip_button = data.buttons & ButtonGrip;
+    msg.trigger_button = data.buttons & ButtonTrigger;
+    msg.trackpad_button = data.buttons & ButtonTrackpad;
+    msg.trackpad_touch = data.buttons & ButtonTrackpadTouch;
+    msg.menu_button = data.buttons & ButtonMenu;
+    msg.trackpad_x = data.trackpad_x;
+    msg.trackpad_y = data.trackpad_y;
+    msg.trigger = data.trigger;
+    msg.pressed_edges = data.pressed_edges;
+    msg.released_edges = data.released_edges;
+    msg.role = data.role;
+    msg.predicted = data.flags & TrackerPredicted;
+    msg.time = time;
+
+    fillTransform(data, trackerFrame(data.device, serial), stamp, msg.abs_pose);
+    msg.raw_pose.header = msg.abs_pose.header;
+    msg.raw_pose.child_frame_id = msg.abs_pose.child_frame_id + "_raw";
+    msg.raw_pose.transform.translation.x = data.raw_x;
+    msg.raw_pose.transform.translation.y = data.raw_y;
+    msg.raw_pose.transform.translation.z = data.raw_z;
+    msg.raw_pose.transform.rotation.x = data.raw_qx;
+    msg.raw_pose.transform.rotation.y = data.raw_qy;
+    msg.raw_pose.transform.rotation.z = data.raw_qz;
+    msg.raw_pose.transform.rotation.w = data.raw_qw;
+
+    msg.velocity.linear.x = data.vel_x;
+    msg.velocity.linear.y = data.vel_y;
+    msg.velocity.linear.z = data.vel_z;
+    msg.velocity.angular.x = data.ang_vel_x;
+    msg.velocity.angular.y = data.ang_vel_y;
+    msg.velocity.angular.z = data.ang_vel_z;
+}
+
+} // namespace vive_messages
+
+#endif // VIVE_MESSAGES_HPP
@@ -0,0 +1,142 @@
+#include "async_logger.hpp"
+#include <chrono>
+#include <cstdio>
+
+AsyncLogger& AsyncLogger::instance() {
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::AsyncLogger() {
+    for (size_t i = 0; i < kCapacity; i++) {
+        records[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+AsyncLogger::~AsyncLogger() {
+    stop();
+}
+
+void AsyncLogger::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    worker = std::thread([this]() {
+        while (running.load(std::memory_order_acquire)) {
+            drain();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        drain();
+    });
+    logSink().store(&AsyncLogger::sink, std::memory_order_release);
+}
+
+void AsyncLogger::stop() {
+    logSink().store(nullptr, std::memory_order_release);
+    if (running.exchange(false) && worker.joinable()) {
+        worker.join();
+    }
+}
+
+void AsyncLogger::sink(LogLevel level, const char* site_key, const char* format, va_list args) {
+    AsyncLogger& logger = instance();
+
+    // Rate limit per call site in one second windows
+    uint32_t suppressed_before = 0;
+    CallSite* site = site_key ? logger.callSite(site_key) : nullptr;
+    if (site) {
+        int64_t now_s = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t window_start = site->window_start.load(std::memory_order_relaxed);
+        if (now_s != window_start && site->window_start.compare_exchange_strong(window_start, now_s)) {
+            site->count.store(0, std::memory_order_relaxed);
+            suppressed_before = site->suppressed.exchange(0, std::memory_order_relaxed);
+        }
+        if (site->count.fetch_add(1, std::memory_order_relaxed) >= kRateLimitBurst) {
+            site->suppressed.fetch_add(1, std::memory_order_relaxed);
+            logger.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    if (!logger.push(level, suppressed_before, format, args)) {
+        logger.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+AsyncLogger::CallSite* AsyncLogger::callSite(const char* key) {
+    size_t index = (reinterpret_cast<uintptr_t>(key) >> 4) & (kCallSites - 1);
+    for (size_t probe = 0; probe < kCallSites; probe++) {
+        CallSite& site = call_sites[(index + probe) & (kCallSites - 1)];
+        const char* current = site.site.load(std::memory_order_acquire);
+        if (current == key) {
+            return &site;
+        }
+        if (current == nullptr) {
+            if (site.site.compare_exchange_strong(current, key) || current == key) {
+                return &site;
+            }
+        }
+    }
+    return nullptr; // Table full, no rate limit for this call site
+}
+
+// Bounded MPSC queue after D. Vyukov: a slot is free for position pos when
+// its sequence equals pos, and holds a record when it equals pos + 1.
+bool AsyncLogger::push(LogLevel level, uint32_t suppressed_before, const char* format, va_list args) {
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    Record* record;
+    while (true) {
+        record = &records[pos & (kCapacity - 1)];
+        size_t sequence = record->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // Full
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    record->level = level;
+    record->suppressed = suppressed_before;
+    vsnprintf(record->text, kMessageSize, format, args);
+    record->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool AsyncLogger::pop() {
+    Record& record = records[dequeue_pos & (kCapacity - 1)];
+    if (record.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) {
+        return false; // Empty, or the producer has not finished the slot yet
+    }
+
+    if (record.suppressed > 0) {
+        char text[kMessageSize + 64];
+        snprintf(text, sizeof(text), "%s (%u similar messages suppressed)", record.text, record.suppressed);
+        writeLog(record.level, text);
+    } else {
+        writeLog(record.level, record.text);
+    }
+
+    record.sequence.store(dequeue_pos + kCapacity, std::memory_order_release);
+    dequeue_pos++;
+    return true;
+}
+
+void AsyncLogger::drain() {
+    while (pop()) {
+    }
+
+    uint64_t dropped_now = dropped.load(std::memory_order_relaxed);
+    if (dropped_now != reported_dropped) {
+        char text[96];
+        snprintf(text, sizeof(text), "%llu log messages dropped (ring full)",
+                 static_cast<unsigned long long>(dropped_now - reported_dropped));
+        writeLog(Warning, text);
+        reported_dropped = dropped_now;
+    }
+}
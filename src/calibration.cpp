@@ -0,0 +1,131 @@
+#include "calibration.hpp"
+#include <cstdio>
+#include <fstream>
+
+#include "json.hpp"
+#include "VRUtils.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+using Transform = transform::RigidTransform<float>;
+
+// {"translation": [x, y, z], "rotation": [qx, qy, qz, qw]}
+Transform parseTransform(const json& j) {
+    Transform t = Transform::identity();
+    if (j.contains("rotation")) {
+        auto q = j.at("rotation").get<std::vector<double>>();
+        if (q.size() != 4) {
+            throw std::runtime_error("rotation must be [qx, qy, qz, qw]");
+        }
+        transform::Quaternion<double> rotation{q[3], q[0], q[1], q[2]};
+        if (rotation.norm2() < 1e-18) {
+            throw std::runtime_error("rotation is not a unit quaternion");
+        }
+        transform::Matrix3<double> r = rotation.normalized().toMatrix();
+        for (int row = 0; row < 3; row++) {
+            for (int col = 0; col < 3; col++) {
+                t.rotation.m[row][col] = static_cast<float>(r.m[row][col]);
+            }
+        }
+    }
+    if (j.contains("translation")) {
+        auto v = j.at("translation").get<std::vector<double>>();
+        if (v.size() != 3) {
+            throw std::runtime_error("translation must be [x, y, z]");
+        }
+        t.translation = {static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2])};
+    }
+    return t;
+}
+
+} // namespace
+
+void CalibrationTransform::apply(vr::TrackedDevicePose_t& pose) const {
+    if (identity) {
+        return;
+    }
+    Transform device = VRTransformUtils::ToRigidTransform(pose.mDeviceToAbsoluteTracking);
+
+    // Tool tip velocity: v + w x (R * t_tool), in universe axes
+    transform::Vector3<float> lever = device.rotation * tool.translation;
+    transform::Vector3<float> v{pose.vVelocity.v[0], pose.vVelocity.v[1], pose.vVelocity.v[2]};
+    transform::Vector3<float> w{pose.vAngularVelocity.v[0], pose.vAngularVelocity.v[1], pose.vAngularVelocity.v[2]};
+    transform::Vector3<float> tip_velocity = world.rotation * (v + w.cross(lever));
+    transform::Vector3<float> angular = world.rotation * w;
+
+    pose.mDeviceToAbsoluteTracking = VRTransformUtils::ToMatrix34(world * device * tool);
+    pose.vVelocity.v[0] = tip_velocity.x;
+    pose.vVelocity.v[1] = tip_velocity.y;
+    pose.vVelocity.v[2] = tip_velocity.z;
+    pose.vAngularVelocity.v[0] = angular.x;
+    pose.vAngularVelocity.v[1] = angular.y;
+    pose.vAngularVelocity.v[2] = angular.z;
+}
+
+bool Calibration::load(const std::string& path) {
+    Entry new_defaults;
+    std::map<std::string, Entry, std::less<>> new_devices;
+    try {
+        std::ifstream file(path);
+        if (!file) {
+            VIVE_LOG(Error, "Cannot open calibration %s", path.c_str());
+            return false;
+        }
+        json j = json::parse(file);
+        new_defaults.world = j.contains("world") ? parseTransform(j.at("world")) : Transform::identity();
+        new_defaults.tool = j.contains("tool") ? parseTransform(j.at("tool")) : Transform::identity();
+        new_defaults.has_world = new_defaults.has_tool = true;
+        if (j.contains("devices")) {
+            for (auto& device : j.at("devices").items()) {
+                Entry entry;
+                if (device.value().contains("world")) {
+                    entry.world = parseTransform(device.value().at("world"));
+                    entry.has_world = true;
+                }
+                if (device.value().contains("tool")) {
+                    entry.tool = parseTransform(device.value().at("tool"));
+                    entry.has_tool = true;
+                }
+                new_devices[device.key()] = entry;
+            }
+        }
+    } catch (const std::exception& e) {
+        VIVE_LOG(Error, "Invalid calibration %s: %s", path.c_str(), e.what());
+        return false;
+    }
+
+    file_path = path;
+    defaults = new_defaults;
+    devices.swap(new_devices);
+    VIVE_LOG(Info, "Loaded calibration %s (%zu devices)", path.c_str(), devices.size());
+    return true;
+}
+
+CalibrationTransform Calibration::resolve(vr::TrackedDeviceIndex_t index, const char* serial, bool with_tool) const {
+    CalibrationTransform transform;
+    transform.world = defaults.world;
+    transform.tool = defaults.tool;
+
+    // A serial number entry takes precedence over a device index entry
+    auto it = serial[0] == '\0' ? devices.end() : devices.find(serial);
+    if (it == devices.end()) {
+        char key[16];
+        std::snprintf(key, sizeof(key), "%u", index);
+        it = devices.find(key);
+    }
+    if (it != devices.end()) {
+        if (it->second.has_world) {
+            transform.world = it->second.world;
+        }
+        if (it->second.has_tool) {
+            transform.tool = it->second.tool;
+        }
+    }
+    if (!with_tool) {
+        transform.tool = Transform::identity();
+    }
+    transform.identity = transform.world.isIdentity() && transform.tool.isIdentity();
+    return transform;
+}
@@ -0,0 +1,82 @@
+#include "config_reloader.hpp"
+#include <utility>
+
+ConfigReloader::ConfigReloader(std::atomic<bool>& requested, const std::string& calibration_path,
+                               const std::string& filter_path, std::chrono::milliseconds period)
+    : requested(requested), calibration_path(calibration_path), filter_path(filter_path), period(period) {
+}
+
+ConfigReloader::~ConfigReloader() {
+    stop();
+}
+
+void ConfigReloader::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    running = true;
+    thread = std::thread(&ConfigReloader::run, this);
+}
+
+void ConfigReloader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+// The request flag is set from a signal handler, which cannot notify, so it is polled
+void ConfigReloader::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        if (requested.exchange(false)) {
+            lock.unlock();
+            reload();
+            lock.lock();
+        }
+        cv.wait_for(lock, period, [this] { return !running; });
+    }
+}
+
+// Parse without the lock, hand over under it; a failed load keeps the configuration in use
+void ConfigReloader::reload() {
+    if (!calibration_path.empty()) {
+        Calibration calibration;
+        if (calibration.load(calibration_path)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            loaded_calibration = std::move(calibration);
+            calibration_ready.store(true, std::memory_order_release);
+        }
+    }
+    if (!filter_path.empty()) {
+        PoseFilterConfig filter;
+        if (filter.load(filter_path)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            loaded_filter = std::move(filter);
+            filter_ready.store(true, std::memory_order_release);
+        }
+    }
+}
+
+ConfigReloader::Applied ConfigReloader::apply(Calibration* calibration, PoseFilterConfig* filter) {
+    Applied applied;
+    if (!calibration_ready.load(std::memory_order_acquire) && !filter_ready.load(std::memory_order_acquire)) {
+        return applied;
+    }
+    // Held only for the swaps by the other side, never during parsing
+    std::lock_guard<std::mutex> lock(mutex);
+    if (calibration && calibration_ready.exchange(false)) {
+        std::swap(*calibration, loaded_calibration);
+        applied.calibration = true;
+    }
+    if (filter && filter_ready.exchange(false)) {
+        std::swap(*filter, loaded_filter);
+        applied.filter = true;
+    }
+    return applied;
+}
@@ -0,0 +1,66 @@
+#include "dead_reckoning.hpp"
+
+#include "VRUtils.hpp"
+
+using Vector = transform::Vector3<float>;
+using Rotation = transform::Quaternion<float>;
+
+void DeadReckoning::reset() {
+    has_last = false;
+    predicting = false;
+    blend_start_ns = -1;
+}
+
+DeadReckoning::Result DeadReckoning::update(int64_t time_ns, int64_t window_ns, vr::TrackedDevicePose_t& pose) {
+    bool tracked = pose.bPoseIsValid && pose.eTrackingResult == vr::TrackingResult_Running_OK;
+    if (tracked) {
+        transform::RigidTransform<float> measured = VRTransformUtils::ToRigidTransform(pose.mDeviceToAbsoluteTracking);
+        Vector p = measured.translation;
+        Rotation q = measured.orientation();
+        if (predicting) {
+            blend_start_ns = time_ns;
+            blend_position = predicted_position - p;
+            blend_orientation = predicted_orientation * q.conjugate();
+            predicting = false;
+        }
+        if (blend_start_ns >= 0) {
+            float s = static_cast<float>(time_ns - blend_start_ns) / static_cast<float>(window_ns);
+            if (s >= 1.0f) {
+                blend_start_ns = -1;
+            } else {
+                p = p + blend_position * (1.0f - s);
+                q = transform::slerp(Rotation::identity(), blend_orientation, 1.0f - s) * q;
+                pose.mDeviceToAbsoluteTracking = VRTransformUtils::ToMatrix34(transform::RigidTransform<float>::fromQuaternion(q, p));
+            }
+        }
+        // Extrapolate from what was published, so a dropout during the blend stays continuous
+        has_last = true;
+        last_time_ns = time_ns;
+        position = p;
+        orientation = q;
+        velocity = {pose.vVelocity.v[0], pose.vVelocity.v[1], pose.vVelocity.v[2]};
+        angular_velocity = {pose.vAngularVelocity.v[0], pose.vAngularVelocity.v[1], pose.vAngularVelocity.v[2]};
+        return Tracked;
+    }
+
+    if (!has_last || time_ns - last_time_ns > window_ns) {
+        predicting = false;
+        blend_start_ns = -1;
+        return Lost;
+    }
+
+    // Constant velocities; the angular velocity is in the published frame, so it rotates from the left
+    float dt = static_cast<float>(time_ns - last_time_ns) * 1e-9f;
+    predicted_position = position + velocity * dt;
+    float rate = angular_velocity.norm();
+    predicted_orientation = rate > 1e-6f ? Rotation::fromAxisAngle(angular_velocity * (1.0f / rate), rate * dt) * orientation : orientation;
+    predicting = true;
+    blend_start_ns = -1;
+
+    pose.mDeviceToAbsoluteTracking = VRTransformUtils::ToMatrix34(
+        transform::RigidTransform<float>::fromQuaternion(predicted_orientation, predicted_position));
+    pose.vVelocity = {{velocity.x, velocity.y, velocity.z}};
+    pose.vAngularVelocity = {{angular_velocity.x, angular_velocity.y, angular_velocity.z}};
+    pose.bPoseIsValid = true;
+    return Predicted;
+}
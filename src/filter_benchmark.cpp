@@ -0,0 +1,187 @@
+// Replays a vive_input recording through the One-Euro pose filter and
+// reports, per tracker, how much jitter it removes and how much lag it adds.
+//
+// Jitter is the RMS of the second difference of consecutive samples (position
+// and rotation angle), which is dominated by noise rather than motion. Lag is
+// the delay of the raw trajectory that best matches the filtered one.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "VRUtils.hpp"
+#include "pose_filter.hpp"
+#include "pose_history.hpp"
+#include "recorder.hpp"
+
+namespace {
+
+constexpr int64_t kMaxLagNs = 200000000;
+constexpr int64_t kLagStepNs = 1000000;
+
+struct Trace {
+    std::vector<uint32_t> frames;
+    std::vector<TimedPose> raw;
+    std::vector<TimedPose> filtered;
+};
+
+struct Jitter {
+    double position = 0.0;  // m
+    double rotation = 0.0;  // rad
+};
+
+// Only over runs of three consecutive frames, so dropouts do not count as motion
+Jitter jitter(const std::vector<uint32_t>& frames, const std::vector<TimedPose>& poses) {
+    double position_sq = 0.0;
+    double rotation_sq = 0.0;
+    uint64_t n = 0;
+    for (size_t k = 1; k + 1 < poses.size(); k++) {
+        if (frames[k - 1] + 1 != frames[k] || frames[k] + 1 != frames[k + 1]) {
+            continue;
+        }
+        transform::Vector3<double> d2 = poses[k + 1].position - poses[k].position * 2.0 + poses[k - 1].position;
+        transform::Quaternion<double> a = poses[k - 1].orientation.conjugate() * poses[k].orientation;
+        transform::Quaternion<double> b = poses[k].orientation.conjugate() * poses[k + 1].orientation;
+        double angle = (a.conjugate() * b).angle();
+        position_sq += d2.dot(d2);
+        rotation_sq += angle * angle;
+        n++;
+    }
+    Jitter j;
+    if (n > 0) {
+        j.position = std::sqrt(position_sq / n);
+        j.rotation = std::sqrt(rotation_sq / n);
+    }
+    return j;
+}
+
+// Delay of the raw trajectory that minimizes the RMS distance to the filtered one
+int64_t positionLag(const Trace& trace) {
+    PoseHistory history(trace.raw.size(), 0);
+    for (const TimedPose& pose : trace.raw) {
+        history.add(0, pose);
+    }
+    int64_t best_lag = 0;
+    double best_error = INFINITY;
+    for (int64_t lag = 0; lag <= kMaxLagNs; lag += kLagStepNs) {
+        double error = 0.0;
+        uint64_t n = 0;
+        for (const TimedPose& pose : trace.filtered) {
+            TimedPose delayed;
+            if (history.lookup(0, pose.time_ns - lag, delayed) != PoseHistory::Interpolated) {
+                continue;
+            }
+            transform::Vector3<double> d = pose.position - delayed.position;
+            error += d.dot(d);
+            n++;
+        }
+        if (n > 0 && error / n < best_error) {
+            best_error = error / n;
+            best_lag = lag;
+        }
+    }
+    return best_lag;
+}
+
+double reduction(double raw, double filtered) {
+    return raw > 0.0 ? 100.0 * (1.0 - filtered / raw) : 0.0;
+}
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s <recording> [options]\n"
+                 "  --filter <file>                  One-Euro parameters (JSON, as for vive_input --filter)\n"
+                 "  --position <min_cutoff> <beta>   override the position parameters\n"
+                 "  --rotation <min_cutoff> <beta>   override the rotation parameters\n",
+                 program);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    std::string recording_path = argv[1];
+    PoseFilterConfig config;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            if (!config.load(argv[++i])) {
+                return 1;
+            }
+        } else if (arg == "--position" && i + 2 < argc) {
+            config.position.min_cutoff = std::atof(argv[++i]);
+            config.position.beta = std::atof(argv[++i]);
+        } else if (arg == "--rotation" && i + 2 < argc) {
+            config.rotation.min_cutoff = std::atof(argv[++i]);
+            config.rotation.beta = std::atof(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if (config.position.min_cutoff <= 0.0 || config.rotation.min_cutoff <= 0.0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    RecordingReader reader;
+    if (!reader.open(recording_path)) {
+        return 1;
+    }
+
+    // Filter the trackers and controllers in recording order, as vive_input would
+    std::vector<Trace> traces(vr::k_unMaxTrackedDeviceCount);
+    PoseFilter filters[vr::k_unMaxTrackedDeviceCount];
+    const RecordedSample* samples = reader.samples();
+    for (uint64_t k = 0; k < reader.count(); k++) {
+        const RecordedSample& s = samples[k];
+        bool input_device = s.device_class == vr::TrackedDeviceClass_GenericTracker || s.device_class == vr::TrackedDeviceClass_Controller;
+        if (!input_device || s.device >= vr::k_unMaxTrackedDeviceCount || !(s.flags & SamplePoseValid)) {
+            continue;
+        }
+        Trace& trace = traces[s.device];
+        if (!trace.frames.empty() && s.frame <= trace.frames.back()) {
+            continue;  // a looped or concatenated recording
+        }
+        TimedPose raw;
+        raw.time_ns = s.time_ns;
+        raw.position = {s.matrix[0][3], s.matrix[1][3], s.matrix[2][3]};
+        transform::quaternionFromRotation<double>(s.matrix[0][0], s.matrix[0][1], s.matrix[0][2],
+                                                  s.matrix[1][0], s.matrix[1][1], s.matrix[1][2],
+                                                  s.matrix[2][0], s.matrix[2][1], s.matrix[2][2],
+                                                  raw.orientation.w, raw.orientation.x, raw.orientation.y, raw.orientation.z);
+        TimedPose filtered = raw;
+        filters[s.device].filter(config, s.time_ns, filtered.position, filtered.orientation);
+        trace.frames.push_back(s.frame);
+        trace.raw.push_back(raw);
+        trace.filtered.push_back(filtered);
+    }
+
+    std::printf("position: min_cutoff %.3f Hz, beta %.3f, d_cutoff %.3f Hz\n",
+                config.position.min_cutoff, config.position.beta, config.position.d_cutoff);
+    std::printf("rotation: min_cutoff %.3f Hz, beta %.3f, d_cutoff %.3f Hz\n",
+                config.rotation.min_cutoff, config.rotation.beta, config.rotation.d_cutoff);
+    std::printf("%6s %9s %22s %10s %22s %10s %8s\n", "device", "samples", "pos jitter raw/filt um",
+                "reduction", "rot jitter raw/filt mdeg", "reduction", "lag ms");
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        const Trace& trace = traces[i];
+        if (trace.raw.size() < 3) {
+            continue;
+        }
+        Jitter raw = jitter(trace.frames, trace.raw);
+        Jitter filtered = jitter(trace.frames, trace.filtered);
+        int64_t lag = positionLag(trace);
+        char position[32];
+        char rotation[32];
+        std::snprintf(position, sizeof(position), "%.1f/%.1f", raw.position * 1e6, filtered.position * 1e6);
+        std::snprintf(rotation, sizeof(rotation), "%.2f/%.2f", raw.rotation * 180e3 / M_PI, filtered.rotation * 180e3 / M_PI);
+        std::printf("%6u %9zu %22s %9.1f%% %22s %9.1f%% %8.1f\n", i, trace.raw.size(), position,
+                    reduction(raw.position, filtered.position), rotation, reduction(raw.rotation, filtered.rotation), lag * 1e-6);
+    }
+    return 0;
+}
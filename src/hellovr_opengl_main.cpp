@@ -22,6 +22,8 @@
 #include <unistd.h>		// for sleep
 #include <cmath>		// for M_PI
 
+#include "VRUtils.hpp"	// pose conversions
+
 #ifndef _WIN32
 #define APIENTRY
 #endif
@@ -39,60 +41,6 @@ void ThreadSleep( unsigned long nMilliseconds )
 #endif
 }
 
-// Function to extract quaternion from the matrix
-vr::HmdQuaternion_t GetQuaternion(vr::HmdMatrix34_t m) {
-    vr::HmdQuaternion_t q;
-
-    q.w = sqrt(fmax(0, 1 + m.m[0][0] + m.m[1][1] + m.m[2][2])) / 2;
-    q.x = sqrt(fmax(0, 1 + m.m[0][0] - m.m[1][1] - m.m[2][2])) / 2;
-    q.y = sqrt(fmax(0, 1 - m.m[0][0] + m.m[1][1] - m.m[2][2])) / 2;
-    q.z = sqrt(fmax(0, 1 - m.m[0][0] - m.m[1][1] + m.m[2][2])) / 2;
-    q.x = copysign(q.x, m.m[2][1] - m.m[1][2]);
-    q.y = copysign(q.y, m.m[0][2] - m.m[2][0]);
-    q.z = copysign(q.z, m.m[1][0] - m.m[0][1]);
-
-    return q;
-}
-// Function to extract position from the matrix
-vr::HmdVector3_t GetPosition(vr::HmdMatrix34_t m) {
-    vr::HmdVector3_t vector;
-
-    vector.v[0] = m.m[0][3];
-    vector.v[1] = m.m[1][3];
-    vector.v[2] = m.m[2][3];
-
-    return vector;
-}
-// Define a structure for Euler angles
-struct EulerAngle {
-    float x; // Pitch
-    float y; // Yaw
-    float z; // Roll
-};
-// Function to convert quaternion to Euler angles (XYZ)
-EulerAngle QuaternionToEulerXYZ(const vr::HmdQuaternion_t& q) {
-    EulerAngle angles;
-
-    // Roll (x-axis rotation)
-    double sinr_cosp = 2 * (q.w * q.x + q.y * q.z);
-    double cosr_cosp = 1 - 2 * (q.x * q.x + q.y * q.y);
-    angles.x = std::atan2(sinr_cosp, cosr_cosp);
-
-    // Pitch (y-axis rotation)
-    double sinp = 2 * (q.w * q.y - q.z * q.x);
-    if (std::abs(sinp) >= 1)
-        angles.y = std::copysign(M_PI / 2, sinp); // use 90 degrees if out of range
-    else
-        angles.y = std::asin(sinp);
-
-    // Yaw (z-axis rotation)
-    double siny_cosp = 2 * (q.w * q.z + q.x * q.y);
-    double cosy_cosp = 1 - 2 * (q.y * q.y + q.z * q.z);
-    angles.z = std::atan2(siny_cosp, cosy_cosp);
-
-    return angles;
-}
-
 class CGLRenderModel
 {
 public:
@@ -884,9 +832,9 @@ bool CMainApplication::HandleInput()
 			
 			// The pose is printed out
 			vr::HmdMatrix34_t steamVRMatrix = poseData.pose.mDeviceToAbsoluteTracking;
-			vr::HmdVector3_t position = GetPosition(steamVRMatrix);
-        	vr::HmdQuaternion_t quaternion = GetQuaternion(steamVRMatrix);
-			EulerAngle euler = QuaternionToEulerXYZ(quaternion);
+			vr::HmdVector3_t position = VRTransformUtils::GetPosition(steamVRMatrix);
+			vr::HmdQuaternion_t quaternion = VRTransformUtils::GetQuaternion(steamVRMatrix);
+			transform::EulerXYZ<double> euler = VRTransformUtils::QuaternionToEulerXYZ(quaternion);
 			printf("(DEBUG)   [POSE CM]: %8.2f %8.2f %8.2f\n", 
 				position.v[0] * 100, position.v[1] * 100, position.v[2] * 100);
 			printf("(DEBUG) [EULER DEG]: %8.2f %8.2f %8.2f %d\n\n", 
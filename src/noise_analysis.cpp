@@ -0,0 +1,411 @@
+// Noise characterization of vive_input recordings: per device, the sample
+// interval jitter, the position and rotation standard deviation at rest and
+// overlapping Allan deviation curves, as JSON or CSV.
+//
+// At rest means the reported linear and angular speeds stay under a
+// threshold; the standard deviations pool all rest segments of at least
+// --min-rest seconds, each about its own mean, and the Allan deviation is
+// taken over the longest one. Files are scanned in parallel, then devices
+// are analyzed in parallel.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json.hpp"
+#include "recorder.hpp"
+#include "transform.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+struct Options {
+    double rest_velocity = 0.02;            // m/s
+    double rest_angular_velocity = 0.05;    // rad/s
+    double min_rest = 1.0;                  // s
+    unsigned threads = 0;
+    bool csv = false;
+};
+
+// Valid samples of one device in one file
+struct Series {
+    uint32_t device = 0;
+    uint8_t device_class = 0;
+    uint64_t samples = 0;                   // including invalid poses
+
+    // Intervals between consecutive samples of the device, s
+    double interval_sum = 0.0;
+    double interval_sum_sq = 0.0;
+    double interval_min = INFINITY;
+    double interval_max = 0.0;
+    int64_t last_time_ns = -1;
+
+    std::vector<int64_t> time_ns;
+    std::vector<transform::Vector3<float>> position;
+    std::vector<transform::Quaternion<float>> orientation;
+    std::vector<uint8_t> rest;
+};
+
+struct FileResult {
+    std::string path;
+    bool ok = false;
+    double duration = 0.0;
+    std::vector<Series> devices;            // sorted by device index
+    std::vector<json> results;              // one per device, filled by the analysis
+};
+
+// Runs f(0) .. f(count - 1) on up to threads workers
+template <typename F>
+void parallelFor(size_t count, unsigned threads, F f) {
+    std::atomic<size_t> next(0);
+    auto worker = [&] {
+        for (size_t k = next++; k < count; k = next++) {
+            f(k);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < std::min<size_t>(threads, count); t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+void scanFile(const Options& options, FileResult& file) {
+    RecordingReader reader;
+    if (!reader.open(file.path)) {
+        return;
+    }
+    Series* by_index[vr::k_unMaxTrackedDeviceCount] = {};
+    std::vector<Series> devices(vr::k_unMaxTrackedDeviceCount);
+    const RecordedSample* samples = reader.samples();
+    double rest_v2 = options.rest_velocity * options.rest_velocity;
+    double rest_w2 = options.rest_angular_velocity * options.rest_angular_velocity;
+
+    for (uint64_t k = 0; k < reader.count(); k++) {
+        const RecordedSample& s = samples[k];
+        if (s.device >= vr::k_unMaxTrackedDeviceCount || s.device_class == vr::TrackedDeviceClass_Invalid) {
+            continue;
+        }
+        Series& series = devices[s.device];
+        if (!by_index[s.device]) {
+            by_index[s.device] = &series;
+            series.device = s.device;
+            series.device_class = s.device_class;
+        }
+        series.samples++;
+        if (series.last_time_ns >= 0 && s.time_ns > series.last_time_ns) {
+            double dt = (s.time_ns - series.last_time_ns) * 1e-9;
+            series.interval_sum += dt;
+            series.interval_sum_sq += dt * dt;
+            series.interval_min = std::min(series.interval_min, dt);
+            series.interval_max = std::max(series.interval_max, dt);
+        }
+        series.last_time_ns = s.time_ns;
+        if (!(s.flags & SamplePoseValid)) {
+            continue;
+        }
+
+        transform::Quaternion<float> q;
+        transform::quaternionFromRotation<float>(s.matrix[0][0], s.matrix[0][1], s.matrix[0][2],
+                                                 s.matrix[1][0], s.matrix[1][1], s.matrix[1][2],
+                                                 s.matrix[2][0], s.matrix[2][1], s.matrix[2][2], q.w, q.x, q.y, q.z);
+        double v2 = s.velocity[0] * s.velocity[0] + s.velocity[1] * s.velocity[1] + s.velocity[2] * s.velocity[2];
+        double w2 = s.angular_velocity[0] * s.angular_velocity[0] + s.angular_velocity[1] * s.angular_velocity[1] +
+                    s.angular_velocity[2] * s.angular_velocity[2];
+        series.time_ns.push_back(s.time_ns);
+        series.position.push_back({s.matrix[0][3], s.matrix[1][3], s.matrix[2][3]});
+        series.orientation.push_back(q);
+        series.rest.push_back(v2 < rest_v2 && w2 < rest_w2);
+    }
+
+    if (reader.count() > 1) {
+        file.duration = (samples[reader.count() - 1].time_ns - samples[0].time_ns) * 1e-9;
+    }
+    for (Series& series : devices) {
+        if (series.samples > 0) {
+            file.devices.push_back(std::move(series));
+        }
+    }
+    file.results.resize(file.devices.size());
+    file.ok = true;
+}
+
+// Axis times angle, with atan2 so that the small angles of noise keep their precision
+transform::Vector3<double> rotationVector(const transform::Quaternion<double>& q) {
+    double s = q.vec().norm();
+    if (s < 1e-15) {
+        return {0.0, 0.0, 0.0};
+    }
+    double sign = q.w < 0.0 ? -1.0 : 1.0;
+    return q.vec() * (sign * 2.0 * std::atan2(s, std::fabs(q.w)) / s);
+}
+
+// Overlapping Allan deviation of x at averaging factors 1, 2, 4, ... up to a quarter of the series
+void allanDeviation(const std::vector<double>& x, std::vector<size_t>& factors, std::vector<double>& deviation) {
+    size_t n = x.size();
+    std::vector<double> sum(n + 1, 0.0);
+    for (size_t k = 0; k < n; k++) {
+        sum[k + 1] = sum[k] + x[k];
+    }
+    factors.clear();
+    deviation.clear();
+    for (size_t m = 1; 4 * m <= n; m *= 2) {
+        double total = 0.0;
+        size_t terms = n - 2 * m + 1;
+        for (size_t k = 0; k < terms; k++) {
+            double d = (sum[k + 2 * m] - 2.0 * sum[k + m] + sum[k]) / m;
+            total += d * d;
+        }
+        factors.push_back(m);
+        deviation.push_back(std::sqrt(total / (2.0 * terms)));
+    }
+}
+
+json analyze(const Options& options, const Series& series) {
+    json result;
+    result["device"] = series.device;
+    result["device_class"] = series.device_class;
+    result["samples"] = series.samples;
+    result["valid_fraction"] = series.samples > 0 ? static_cast<double>(series.time_ns.size()) / series.samples : 0.0;
+
+    uint64_t intervals = series.samples > 0 ? series.samples - 1 : 0;
+    double interval_mean = intervals > 0 ? series.interval_sum / intervals : 0.0;
+    double interval_var = intervals > 0 ? std::max(0.0, series.interval_sum_sq / intervals - interval_mean * interval_mean) : 0.0;
+    result["interval"] = {{"mean", interval_mean}, {"std", std::sqrt(interval_var)},
+                          {"min", intervals > 0 ? series.interval_min : 0.0}, {"max", series.interval_max}};
+
+    // Rest segments: runs of rest samples without a gap of more than 10 intervals
+    int64_t max_gap_ns = static_cast<int64_t>(10.0 * interval_mean * 1e9);
+    std::vector<std::pair<size_t, size_t>> segments;
+    size_t n = series.time_ns.size();
+    for (size_t begin = 0; begin < n;) {
+        if (!series.rest[begin]) {
+            begin++;
+            continue;
+        }
+        size_t end = begin + 1;
+        while (end < n && series.rest[end] && series.time_ns[end] - series.time_ns[end - 1] <= max_gap_ns) {
+            end++;
+        }
+        if ((series.time_ns[end - 1] - series.time_ns[begin]) * 1e-9 >= options.min_rest) {
+            segments.push_back({begin, end});
+        }
+        begin = end;
+    }
+
+    // Deviations about each segment's mean pose, the rotation as a rotation vector
+    double position_sq[3] = {0.0, 0.0, 0.0};
+    double rotation_sq[3] = {0.0, 0.0, 0.0};
+    uint64_t rest_samples = 0;
+    double rest_duration = 0.0;
+    size_t longest = 0;
+    std::vector<double> allan_input[6];
+    for (size_t s = 0; s < segments.size(); s++) {
+        size_t begin = segments[s].first;
+        size_t end = segments[s].second;
+        bool keep = (end - begin) > (segments[longest].second - segments[longest].first) || s == 0;
+        if (keep) {
+            longest = s;
+            for (std::vector<double>& v : allan_input) {
+                v.clear();
+            }
+        }
+        transform::Vector3<double> mean_position{0.0, 0.0, 0.0};
+        transform::Quaternion<double> mean_orientation{0.0, 0.0, 0.0, 0.0};
+        const transform::Quaternion<float>& first = series.orientation[begin];
+        for (size_t k = begin; k < end; k++) {
+            const transform::Vector3<float>& p = series.position[k];
+            const transform::Quaternion<float>& q = series.orientation[k];
+            double sign = first.dot(q) < 0.0f ? -1.0 : 1.0;
+            mean_position = mean_position + transform::Vector3<double>{p.x, p.y, p.z};
+            mean_orientation = {mean_orientation.w + sign * q.w, mean_orientation.x + sign * q.x,
+                                mean_orientation.y + sign * q.y, mean_orientation.z + sign * q.z};
+        }
+        mean_position = mean_position * (1.0 / (end - begin));
+        transform::Quaternion<double> mean_inverse = mean_orientation.normalized().conjugate();
+        for (size_t k = begin; k < end; k++) {
+            const transform::Vector3<float>& p = series.position[k];
+            const transform::Quaternion<float>& qf = series.orientation[k];
+            transform::Vector3<double> d{p.x - mean_position.x, p.y - mean_position.y, p.z - mean_position.z};
+            transform::Quaternion<double> q = mean_inverse * transform::Quaternion<double>{qf.w, qf.x, qf.y, qf.z};
+            transform::Vector3<double> r = rotationVector(q);
+            const double dp[3] = {d.x, d.y, d.z};
+            const double dr[3] = {r.x, r.y, r.z};
+            for (int a = 0; a < 3; a++) {
+                position_sq[a] += dp[a] * dp[a];
+                rotation_sq[a] += dr[a] * dr[a];
+                if (keep) {
+                    allan_input[a].push_back(dp[a]);
+                    allan_input[3 + a].push_back(dr[a]);
+                }
+            }
+        }
+        rest_samples += end - begin;
+        rest_duration += (series.time_ns[end - 1] - series.time_ns[begin]) * 1e-9;
+    }
+
+    json rest;
+    rest["segments"] = segments.size();
+    rest["samples"] = rest_samples;
+    rest["duration"] = rest_duration;
+    if (rest_samples > 0) {
+        json position_std = json::array();
+        json rotation_std = json::array();
+        for (int a = 0; a < 3; a++) {
+            position_std.push_back(std::sqrt(position_sq[a] / rest_samples));
+            rotation_std.push_back(std::sqrt(rotation_sq[a] / rest_samples));
+        }
+        rest["position_std"] = position_std;
+        rest["position_std_3d"] = std::sqrt((position_sq[0] + position_sq[1] + position_sq[2]) / rest_samples);
+        rest["rotation_std"] = rotation_std;
+        rest["rotation_std_3d"] = std::sqrt((rotation_sq[0] + rotation_sq[1] + rotation_sq[2]) / rest_samples);
+
+        json allan;
+        std::vector<size_t> factors;
+        std::vector<double> deviation[6];
+        for (int a = 0; a < 6; a++) {
+            allanDeviation(allan_input[a], factors, deviation[a]);
+        }
+        json tau = json::array();
+        json position = json::array();
+        json rotation = json::array();
+        for (size_t f = 0; f < factors.size(); f++) {
+            tau.push_back(factors[f] * interval_mean);
+            position.push_back({deviation[0][f], deviation[1][f], deviation[2][f]});
+            rotation.push_back({deviation[3][f], deviation[4][f], deviation[5][f]});
+        }
+        allan["samples"] = allan_input[0].size();
+        allan["tau"] = tau;
+        allan["position"] = position;
+        allan["rotation"] = rotation;
+        rest["allan"] = allan;
+    }
+    result["rest"] = rest;
+    return result;
+}
+
+// One row per value: file,device,statistic,tau,value
+void writeCsv(const std::vector<FileResult>& files) {
+    std::printf("file,device,statistic,tau,value\n");
+    const char* axes[3] = {"x", "y", "z"};
+    for (const FileResult& file : files) {
+        for (const json& r : file.results) {
+            unsigned device = r["device"];
+            auto row = [&](const std::string& statistic, const json& value, double tau = NAN) {
+                std::printf("%s,%u,%s,", file.path.c_str(), device, statistic.c_str());
+                if (!std::isnan(tau)) {
+                    std::printf("%.9g", tau);
+                }
+                std::printf(",%.9g\n", value.get<double>());
+            };
+            row("samples", r["samples"]);
+            row("valid_fraction", r["valid_fraction"]);
+            for (const auto& item : r["interval"].items()) {
+                row("interval_" + item.key(), item.value());
+            }
+            const json& rest = r["rest"];
+            row("rest_duration", rest["duration"]);
+            if (!rest.contains("allan")) {
+                continue;
+            }
+            for (int a = 0; a < 3; a++) {
+                row(std::string("position_std_") + axes[a], rest["position_std"][a]);
+                row(std::string("rotation_std_") + axes[a], rest["rotation_std"][a]);
+            }
+            row("position_std_3d", rest["position_std_3d"]);
+            row("rotation_std_3d", rest["rotation_std_3d"]);
+            const json& allan = rest["allan"];
+            for (size_t f = 0; f < allan["tau"].size(); f++) {
+                double tau = allan["tau"][f];
+                for (int a = 0; a < 3; a++) {
+                    row(std::string("allan_position_") + axes[a], allan["position"][f][a], tau);
+                    row(std::string("allan_rotation_") + axes[a], allan["rotation"][f][a], tau);
+                }
+            }
+        }
+    }
+}
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [options] <recording>...\n"
+                 "  --csv                         CSV instead of JSON\n"
+                 "  --threads <n>                 worker threads (default: all cores)\n"
+                 "  --rest-velocity <m/s>         speed below which a device is at rest (default 0.02)\n"
+                 "  --rest-angular-velocity <r/s> angular speed below which a device is at rest (default 0.05)\n"
+                 "  --min-rest <s>                shortest rest segment used (default 1)\n"
+                 "Positions in m, rotations in rad, times in s.\n",
+                 program);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    std::vector<FileResult> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--csv") {
+            options.csv = true;
+        } else if (arg == "--threads" && has_value) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (arg == "--rest-velocity" && has_value) {
+            options.rest_velocity = std::atof(argv[++i]);
+        } else if (arg == "--rest-angular-velocity" && has_value) {
+            options.rest_angular_velocity = std::atof(argv[++i]);
+        } else if (arg == "--min-rest" && has_value) {
+            options.min_rest = std::atof(argv[++i]);
+        } else if (arg.empty() || arg[0] == '-') {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        } else {
+            files.emplace_back();
+            files.back().path = arg;
+        }
+    }
+    if (files.empty() || options.min_rest <= 0.0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (options.threads == 0) {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    parallelFor(files.size(), options.threads, [&](size_t f) { scanFile(options, files[f]); });
+
+    std::vector<std::pair<size_t, size_t>> jobs;
+    for (size_t f = 0; f < files.size(); f++) {
+        for (size_t d = 0; d < files[f].devices.size(); d++) {
+            jobs.push_back({f, d});
+        }
+    }
+    parallelFor(jobs.size(), options.threads, [&](size_t k) {
+        FileResult& file = files[jobs[k].first];
+        file.results[jobs[k].second] = analyze(options, file.devices[jobs[k].second]);
+    });
+
+    int status = 0;
+    if (options.csv) {
+        writeCsv(files);
+    } else {
+        json out = json::array();
+        for (const FileResult& file : files) {
+            out.push_back({{"file", file.path}, {"ok", file.ok}, {"duration", file.duration}, {"devices", file.results}});
+        }
+        std::printf("%s\n", out.dump(2).c_str());
+    }
+    for (const FileResult& file : files) {
+        status |= file.ok ? 0 : 1;
+    }
+    return status;
+}
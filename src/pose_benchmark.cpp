@@ -0,0 +1,271 @@
+// Microbenchmarks of the per-poll pose math of vive_input, on synthetic
+// device poses. Prints the time per poll iteration of each variant.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "VRUtils.hpp"
+#include "pose_batch.hpp"
+
+namespace {
+
+constexpr uint32_t kDevices = vr::k_unMaxTrackedDeviceCount;
+
+// Keeps the compiler from dropping or hoisting the measured work
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Best of several runs, the one least disturbed by the rest of the system
+template <typename F>
+double nsPerIteration(int iterations, F&& f) {
+    constexpr int kRuns = 20;
+    const int per_run = std::max(1, iterations / kRuns);
+    double best = INFINITY;
+    f(); // warm up caches and branch predictors
+    for (int run = 0; run < kRuns; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int k = 0; k < per_run; k++) {
+            f();
+        }
+        best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / per_run);
+    }
+    return best;
+}
+
+// Random rotations with small velocities, all devices connected and tracked
+void makePoses(vr::TrackedDevicePose_t* poses, uint32_t count) {
+    std::mt19937 rng(1);
+    std::normal_distribution<double> gauss;
+    std::memset(poses, 0, count * sizeof(*poses));
+    for (uint32_t i = 0; i < count; i++) {
+        transform::Quaternion<double> q = transform::Quaternion<double>{gauss(rng), gauss(rng), gauss(rng), gauss(rng)}.normalized();
+        transform::Matrix3<double> r = q.toMatrix();
+        vr::HmdMatrix34_t& m = poses[i].mDeviceToAbsoluteTracking;
+        for (int row = 0; row < 3; row++) {
+            for (int col = 0; col < 3; col++) {
+                m.m[row][col] = static_cast<float>(r.m[row][col]);
+            }
+            m.m[row][3] = static_cast<float>(gauss(rng));
+            poses[i].vVelocity.v[row] = static_cast<float>(0.1 * gauss(rng));
+            poses[i].vAngularVelocity.v[row] = static_cast<float>(0.1 * gauss(rng));
+        }
+        poses[i].bDeviceIsConnected = true;
+        poses[i].bPoseIsValid = true;
+        poses[i].eTrackingResult = vr::TrackingResult_Running_OK;
+    }
+}
+
+// The extraction GetQuaternion() used before Shepperd's method: four square
+// roots, signs from copysign, not normalized
+vr::HmdQuaternion_t legacyQuaternion(const vr::HmdMatrix34_t& m) {
+    vr::HmdQuaternion_t q;
+    q.w = std::sqrt(std::fmax(0, 1 + m.m[0][0] + m.m[1][1] + m.m[2][2])) / 2;
+    q.x = std::sqrt(std::fmax(0, 1 + m.m[0][0] - m.m[1][1] - m.m[2][2])) / 2;
+    q.y = std::sqrt(std::fmax(0, 1 - m.m[0][0] + m.m[1][1] - m.m[2][2])) / 2;
+    q.z = std::sqrt(std::fmax(0, 1 - m.m[0][0] - m.m[1][1] + m.m[2][2])) / 2;
+    q.x = std::copysign(q.x, m.m[2][1] - m.m[1][2]);
+    q.y = std::copysign(q.y, m.m[0][2] - m.m[2][0]);
+    q.z = std::copysign(q.z, m.m[1][0] - m.m[0][1]);
+    return q;
+}
+
+// Quaternions of all 64 device slots of one GetDeviceToAbsoluteTrackingPose call
+void benchmarkQuaternions(int iterations) {
+    static vr::TrackedDevicePose_t poses[kDevices];
+    static vr::HmdQuaternion_t out[kDevices];
+    makePoses(poses, kDevices);
+
+    double legacy = nsPerIteration(iterations, [&] {
+        for (uint32_t i = 0; i < kDevices; i++) {
+            out[i] = legacyQuaternion(poses[i].mDeviceToAbsoluteTracking);
+        }
+        keep(out);
+    });
+    double single = nsPerIteration(iterations, [&] {
+        for (uint32_t i = 0; i < kDevices; i++) {
+            out[i] = VRTransformUtils::GetQuaternion(poses[i].mDeviceToAbsoluteTracking);
+        }
+        keep(out);
+    });
+    double batch = nsPerIteration(iterations, [&] {
+        VRTransformUtils::GetQuaternions(poses, kDevices, out);
+        keep(out);
+    });
+    std::printf("quaternion extraction, %u devices (ns per poll)\n", kDevices);
+    std::printf("  legacy copysign        %8.0f\n", legacy);
+    std::printf("  GetQuaternion per slot %8.0f\n", single);
+    std::printf("  GetQuaternions         %8.0f\n", batch);
+}
+
+// What the acquisition loop collects per published device: the per-slot walk
+// over the OpenVR array into one record per device, against the PoseBatch
+// the loop fills, for typical and maximal device counts
+void benchmarkAcquisition(int iterations) {
+    struct Record {
+        double position[3];
+        double orientation[4];
+        double velocity[3];
+        double angular_velocity[3];
+    };
+    static vr::TrackedDevicePose_t poses[kDevices];
+    static Record records[kDevices];
+    static PoseBatch batch;
+    makePoses(poses, kDevices);
+
+    std::printf("pose acquisition (ns per poll)\n");
+    std::printf("  devices   per-slot   PoseBatch\n");
+    for (uint32_t n : {1u, 8u, 64u}) {
+        for (uint32_t i = 0; i < kDevices; i++) {
+            poses[i].bDeviceIsConnected = i < n;
+            poses[i].bPoseIsValid = i < n;
+        }
+        double slot = nsPerIteration(iterations, [&] {
+            for (uint32_t i = 0; i < kDevices; i++) {
+                if (!poses[i].bDeviceIsConnected || !poses[i].bPoseIsValid) {
+                    continue;
+                }
+                const vr::HmdMatrix34_t& m = poses[i].mDeviceToAbsoluteTracking;
+                vr::HmdQuaternion_t q = VRTransformUtils::GetQuaternion(m);
+                vr::HmdVector3_t p = VRTransformUtils::GetPosition(m);
+                Record& r = records[i];
+                r.orientation[0] = q.w;
+                r.orientation[1] = q.x;
+                r.orientation[2] = q.y;
+                r.orientation[3] = q.z;
+                for (int row = 0; row < 3; row++) {
+                    r.position[row] = p.v[row];
+                    r.velocity[row] = poses[i].vVelocity.v[row];
+                    r.angular_velocity[row] = poses[i].vAngularVelocity.v[row];
+                }
+            }
+            keep(records);
+        });
+        double batched = nsPerIteration(iterations, [&] {
+            batch.clear();
+            for (uint32_t i = 0; i < kDevices; i++) {
+                if (!poses[i].bDeviceIsConnected || !poses[i].bPoseIsValid) {
+                    continue;
+                }
+                batch.add(i, poses[i], 0);
+            }
+            keep(batch);
+        });
+        std::printf("  %7u   %8.0f   %9.0f\n", n, slot, batched);
+    }
+}
+
+// The 3x4 product calibration.cpp had before transform.hpp, loops and all
+vr::HmdMatrix34_t legacyMultiply(const vr::HmdMatrix34_t& a, const vr::HmdMatrix34_t& b) {
+    vr::HmdMatrix34_t out;
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) {
+            out.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c];
+        }
+        out.m[r][3] += a.m[r][3];
+    }
+    return out;
+}
+
+// transform.hpp for 64 devices: world * pose * tool as the calibration does
+// it, against the hand-written product it replaced, and the quaternion
+// operations of the relative poses and the filter. Anything not inlined or
+// not straight-line shows up as a gap to the hand-written product or as
+// product and rotate costing more than a few ns per device.
+void benchmarkTransforms(int iterations) {
+    using Transform = transform::RigidTransform<float>;
+    using Quaternion = transform::Quaternion<double>;
+    static vr::TrackedDevicePose_t poses[kDevices];
+    static vr::HmdMatrix34_t matrices[kDevices];
+    static Quaternion a[kDevices], b[kDevices], q[kDevices];
+    static transform::Vector3<double> v[kDevices];
+    makePoses(poses, kDevices);
+    const vr::HmdMatrix34_t& world_matrix = poses[0].mDeviceToAbsoluteTracking;
+    const vr::HmdMatrix34_t& tool_matrix = poses[1].mDeviceToAbsoluteTracking;
+    const Transform world = VRTransformUtils::ToRigidTransform(world_matrix);
+    const Transform tool = VRTransformUtils::ToRigidTransform(tool_matrix);
+    for (uint32_t i = 0; i < kDevices; i++) {
+        vr::HmdQuaternion_t qa = VRTransformUtils::GetQuaternion(poses[i].mDeviceToAbsoluteTracking);
+        vr::HmdQuaternion_t qb = VRTransformUtils::GetQuaternion(poses[(i + 1) % kDevices].mDeviceToAbsoluteTracking);
+        a[i] = {qa.w, qa.x, qa.y, qa.z};
+        b[i] = {qb.w, qb.x, qb.y, qb.z};
+        v[i] = {poses[i].vVelocity.v[0], poses[i].vVelocity.v[1], poses[i].vVelocity.v[2]};
+    }
+
+    double legacy = nsPerIteration(iterations, [&] {
+        for (uint32_t i = 0; i < kDevices; i++) {
+            matrices[i] = legacyMultiply(world_matrix, legacyMultiply(poses[i].mDeviceToAbsoluteTracking, tool_matrix));
+        }
+        keep(matrices);
+    });
+    double composed = nsPerIteration(iterations, [&] {
+        for (uint32_t i = 0; i < kDevices; i++) {
+            matrices[i] = VRTransformUtils::ToMatrix34(world * VRTransformUtils::ToRigidTransform(poses[i].mDeviceToAbsoluteTracking) * tool);
+        }
+        keep(matrices);
+    });
+    double inverse = nsPerIteration(iterations, [&] {
+        for (uint32_t i = 0; i < kDevices; i++) {
+            Transform t = VRTransformUtils::ToRigidTransform(poses[i].mDeviceToAbsoluteTracking);
+            matrices[i] = VRTransformUtils::ToMatrix34(world.inverse() * t);
+        }
+        keep(matrices);
+    });
+    double product = nsPerIteration(iterations, [&] {
+        for (uint32_t i = 0; i < kDevices; i++) {
+            q[i] = a[i].conjugate() * b[i];
+        }
+        keep(q);
+    });
+    double rotate = nsPerIteration(iterations, [&] {
+        for (uint32_t i = 0; i < kDevices; i++) {
+            v[i] = a[i].rotate(v[i]);
+        }
+        keep(v);
+    });
+    double slerp = nsPerIteration(iterations, [&] {
+        for (uint32_t i = 0; i < kDevices; i++) {
+            q[i] = transform::slerp(a[i], b[i], 0.25);
+        }
+        keep(q);
+    });
+    std::printf("transforms, %u devices (ns per poll)\n", kDevices);
+    std::printf("  hand-written 3x4 product %6.0f\n", legacy);
+    std::printf("  world * pose * tool      %6.0f\n", composed);
+    std::printf("  inverse * pose           %6.0f\n", inverse);
+    std::printf("  quaternion product       %6.0f\n", product);
+    std::printf("  quaternion rotate        %6.0f\n", rotate);
+    std::printf("  slerp                    %6.0f\n", slerp);
+}
+
+void usage(const char* name) {
+    std::fprintf(stderr, "Usage: %s [--iterations <n>]\n", name);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = 200000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (iterations <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    benchmarkQuaternions(iterations);
+    benchmarkAcquisition(iterations);
+    benchmarkTransforms(iterations);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+#include "pose_filter.hpp"
+#include <fstream>
+
+#include "json.hpp"
+#include "VRUtils.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+OneEuroParams parseParams(const json& j, OneEuroParams params) {
+    params.min_cutoff = j.value("min_cutoff", params.min_cutoff);
+    params.beta = j.value("beta", params.beta);
+    params.d_cutoff = j.value("d_cutoff", params.d_cutoff);
+    if (params.min_cutoff <= 0.0 || params.d_cutoff <= 0.0 || params.beta < 0.0) {
+        throw std::runtime_error("cutoffs must be positive and beta not negative");
+    }
+    return params;
+}
+
+// Smoothing factor of an exponential filter with cutoff frequency fc
+double alpha(double dt, double fc) {
+    double tau = 1.0 / (2.0 * M_PI * fc);
+    return 1.0 / (1.0 + tau / dt);
+}
+
+} // namespace
+
+bool PoseFilterConfig::load(const std::string& path) {
+    OneEuroParams new_position;
+    OneEuroParams new_rotation;
+    try {
+        std::ifstream file(path);
+        if (!file) {
+            VIVE_LOG(Error, "Cannot open filter configuration %s", path.c_str());
+            return false;
+        }
+        json j = json::parse(file);
+        if (j.contains("position")) {
+            new_position = parseParams(j.at("position"), new_position);
+        }
+        if (j.contains("rotation")) {
+            new_rotation = parseParams(j.at("rotation"), new_rotation);
+        }
+    } catch (const std::exception& e) {
+        VIVE_LOG(Error, "Invalid filter configuration %s: %s", path.c_str(), e.what());
+        return false;
+    }
+
+    file_path = path;
+    position = new_position;
+    rotation = new_rotation;
+    VIVE_LOG(Info, "Loaded filter configuration %s: position %.2f Hz + %.2f, rotation %.2f Hz + %.2f", path.c_str(),
+             position.min_cutoff, position.beta, rotation.min_cutoff, rotation.beta);
+    return true;
+}
+
+void PoseFilter::filter(const PoseFilterConfig& config, int64_t time_ns,
+                        transform::Vector3<double>& position, transform::Quaternion<double>& orientation) {
+    double dt = (time_ns - last_time_ns) * 1e-9;
+    if (!initialized || dt <= 0.0) {
+        if (!initialized) {
+            position_ = position;
+            orientation_ = orientation;
+            velocity = {0.0, 0.0, 0.0};
+            angular_speed = 0.0;
+            last_time_ns = time_ns;
+            initialized = true;
+        }
+        position = position_;
+        orientation = orientation_;
+        return;
+    }
+    last_time_ns = time_ns;
+
+    // Position: speed from the previous output, then a cutoff that follows it
+    const OneEuroParams& p = config.position;
+    velocity = velocity + ((position - position_) * (1.0 / dt) - velocity) * alpha(dt, p.d_cutoff);
+    position_ = position_ + (position - position_) * alpha(dt, p.min_cutoff + p.beta * velocity.norm());
+    position = position_;
+
+    // Rotation: the same on the angle to the previous output, applied with slerp
+    const OneEuroParams& r = config.rotation;
+    double angle = (orientation_.conjugate() * orientation).angle();
+    angular_speed += (angle / dt - angular_speed) * alpha(dt, r.d_cutoff);
+    orientation_ = transform::slerp(orientation_, orientation, alpha(dt, r.min_cutoff + r.beta * angular_speed));
+    // Published with w >= 0 like the unfiltered quaternions
+    orientation = orientation_.w < 0.0 ? -orientation_ : orientation_;
+}
@@ -0,0 +1,111 @@
+#include "pose_history.hpp"
+#include <algorithm>
+
+PoseHistory::PoseHistory(size_t capacity, int64_t max_extrapolation_ns)
+    : capacity(std::max<size_t>(capacity, 2)), max_extrapolation_ns(max_extrapolation_ns) {}
+
+bool PoseHistory::add(uint32_t device, const TimedPose& pose) {
+    if (device >= kMaxDevices) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    Ring& ring = rings[device];
+    if (ring.count > 0 && pose.time_ns <= ring.at(ring.count - 1).time_ns) {
+        return false;
+    }
+    if (ring.samples.empty()) {
+        ring.samples.resize(capacity);
+    }
+    if (ring.count < capacity) {
+        ring.samples[(ring.head + ring.count) % capacity] = pose;
+        ring.count++;
+    } else {
+        // Full: overwrite the oldest sample
+        ring.samples[ring.head] = pose;
+        ring.head = (ring.head + 1) % capacity;
+    }
+    return true;
+}
+
+PoseHistory::Result PoseHistory::lookup(uint32_t device, int64_t time_ns, TimedPose& pose) const {
+    if (device >= kMaxDevices) {
+        return NoData;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    const Ring& ring = rings[device];
+    if (ring.count == 0) {
+        return NoData;
+    }
+    const TimedPose& oldest = ring.at(0);
+    const TimedPose& newest = ring.at(ring.count - 1);
+    if (time_ns < oldest.time_ns - max_extrapolation_ns) {
+        return TooOld;
+    }
+    if (time_ns > newest.time_ns + max_extrapolation_ns) {
+        return TooNew;
+    }
+    if (ring.count == 1) {
+        // Nothing to extrapolate with, hold the only pose
+        pose = oldest;
+        pose.time_ns = time_ns;
+        return time_ns == oldest.time_ns ? Interpolated : Extrapolated;
+    }
+
+    // First sample after time_ns, clamped so [lo - 1, lo] is a valid pair
+    size_t lo = 1;
+    size_t hi = ring.count - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ring.at(mid).time_ns <= time_ns) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    pose = interpolate(ring.at(lo - 1), ring.at(lo), time_ns);
+    return time_ns < oldest.time_ns || time_ns > newest.time_ns ? Extrapolated : Interpolated;
+}
+
+bool PoseHistory::range(uint32_t device, int64_t& oldest_ns, int64_t& newest_ns) const {
+    if (device >= kMaxDevices) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    const Ring& ring = rings[device];
+    if (ring.count == 0) {
+        return false;
+    }
+    oldest_ns = ring.at(0).time_ns;
+    newest_ns = ring.at(ring.count - 1).time_ns;
+    return true;
+}
+
+void PoseHistory::clear(uint32_t device) {
+    if (device >= kMaxDevices) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    rings[device].head = 0;
+    rings[device].count = 0;
+}
+
+// Outside [a, b] the fraction leaves [0, 1], which extrapolates along the same line and arc
+TimedPose PoseHistory::interpolate(const TimedPose& a, const TimedPose& b, int64_t time_ns) {
+    double t = static_cast<double>(time_ns - a.time_ns) / static_cast<double>(b.time_ns - a.time_ns);
+    TimedPose pose;
+    pose.time_ns = time_ns;
+    pose.position = a.position + (b.position - a.position) * t;
+    pose.orientation = transform::slerp(a.orientation, b.orientation, t);
+    return pose;
+}
+
+const char* PoseHistory::resultName(Result result) {
+    switch (result) {
+        case Interpolated: return "interpolated";
+        case Extrapolated: return "extrapolated";
+        case TooOld:       return "older than the pose history";
+        case TooNew:       return "newer than the pose history";
+        case NoData:       return "no poses for this device";
+    }
+    return "unknown";
+}
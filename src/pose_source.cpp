@@ -0,0 +1,130 @@
+#include "pose_source.hpp"
+#include <mutex>
+#include "VRUtils.hpp"
+
+OpenVRPoseSource::~OpenVRPoseSource() {
+    shutdown();
+}
+
+bool OpenVRPoseSource::init() {
+    std::unique_lock<std::shared_mutex> lock(runtime_mutex);
+    lost.store(false, std::memory_order_relaxed);
+    // Initialize VR runtime
+    eError = vr::VRInitError_None;
+    pHMD = vr::VR_Init(&eError, vr::VRApplication_Background);
+    if (eError != vr::VRInitError_None) {
+        pHMD = NULL;
+        VIVE_LOG(Error, "Unable to init VR runtime: %s", vr::VR_GetVRInitErrorAsEnglishDescription(eError));
+        return false;
+    } else {
+        VIVE_LOG(Info, "VR runtime initialized");
+    }
+    return true;
+}
+
+void OpenVRPoseSource::shutdown() {
+    std::unique_lock<std::shared_mutex> lock(runtime_mutex);
+    // Shutdown VR runtime
+    if (pHMD) {
+        VIVE_LOG(Info, "Shutting down VR runtime");
+        vr::VR_Shutdown();
+        pHMD = NULL;
+    }
+}
+
+// Every query takes the runtime lock and tolerates a shut down runtime, so a
+// call after shutdown() reports no devices instead of crashing
+
+void OpenVRPoseSource::getPoses(vr::TrackedDevicePose_t* poses, uint32_t count) {
+    std::shared_lock<std::shared_mutex> lock(runtime_mutex);
+    if (!pHMD) {
+        for (uint32_t i = 0; i < count; i++) {
+            poses[i].bDeviceIsConnected = false;
+            poses[i].bPoseIsValid = false;
+            poses[i].eTrackingResult = vr::TrackingResult_Uninitialized;
+        }
+        return;
+    }
+    pHMD->GetDeviceToAbsoluteTrackingPose(vr::TrackingUniverseStanding, 0, poses, count);
+}
+
+vr::ETrackedDeviceClass OpenVRPoseSource::getDeviceClass(vr::TrackedDeviceIndex_t i) {
+    std::shared_lock<std::shared_mutex> lock(runtime_mutex);
+    if (!pHMD) {
+        return vr::TrackedDeviceClass_Invalid;
+    }
+    return pHMD->GetTrackedDeviceClass(i);
+}
+
+vr::ETrackedControllerRole OpenVRPoseSource::getControllerRole(vr::TrackedDeviceIndex_t i) {
+    std::shared_lock<std::shared_mutex> lock(runtime_mutex);
+    if (!pHMD) {
+        return vr::TrackedControllerRole_Invalid;
+    }
+    return VRUtils::controllerRoleCheck(pHMD, i);
+}
+
+bool OpenVRPoseSource::getControllerStateWithPose(vr::TrackedDeviceIndex_t i, vr::VRControllerState_t* state, vr::TrackedDevicePose_t* pose) {
+    std::shared_lock<std::shared_mutex> lock(runtime_mutex);
+    if (!pHMD) {
+        return false;
+    }
+    return pHMD->GetControllerStateWithPose(vr::TrackingUniverseStanding, i, state, sizeof(*state), pose);
+}
+
+bool OpenVRPoseSource::pollNextEvent(vr::VREvent_t* event) {
+    std::shared_lock<std::shared_mutex> lock(runtime_mutex);
+    if (!pHMD || !pHMD->PollNextEvent(event, sizeof(*event))) {
+        return false;
+    }
+    if (event->eventType == vr::VREvent_Quit) {
+        VIVE_LOG(Warning, "VR runtime is quitting");
+        lost.store(true, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// The runtime announces a regular shutdown with VREvent_Quit. A crashed
+// vrserver only shows as failing IPC: query the first device that exists
+// (there may be no HMD in tracker-only setups, and an absent device reports
+// InvalidDevice whether or not the server is reachable)
+void OpenVRPoseSource::probe() {
+    std::shared_lock<std::shared_mutex> lock(runtime_mutex);
+    if (!pHMD || lost.load(std::memory_order_relaxed)) {
+        return;
+    }
+    for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        char name[64];
+        vr::ETrackedPropertyError error = vr::TrackedProp_Success;
+        pHMD->GetStringTrackedDeviceProperty(i, vr::Prop_TrackingSystemName_String, name, sizeof(name), &error);
+        if (error == vr::TrackedProp_InvalidDevice) {
+            continue;
+        }
+        if (error == vr::TrackedProp_CouldNotContactServer) {
+            VIVE_LOG(Warning, "Lost the connection to the VR runtime");
+            lost.store(true, std::memory_order_relaxed);
+        }
+        return;
+    }
+}
+
+bool OpenVRPoseSource::getDeviceMetadata(vr::TrackedDeviceIndex_t i, DeviceMetadata& metadata) {
+    std::shared_lock<std::shared_mutex> lock(runtime_mutex);
+    if (!pHMD) {
+        return false;
+    }
+    vr::ETrackedDeviceClass device_class = pHMD->GetTrackedDeviceClass(i);
+    if (device_class == vr::TrackedDeviceClass_Invalid || !pHMD->IsTrackedDeviceConnected(i)) {
+        return false;
+    }
+    metadata.device_class = static_cast<uint8_t>(device_class);
+    pHMD->GetStringTrackedDeviceProperty(i, vr::Prop_SerialNumber_String, metadata.serial, sizeof(metadata.serial));
+    pHMD->GetStringTrackedDeviceProperty(i, vr::Prop_ModelNumber_String, metadata.model, sizeof(metadata.model));
+    pHMD->GetStringTrackedDeviceProperty(i, vr::Prop_TrackingFirmwareVersion_String, metadata.firmware, sizeof(metadata.firmware));
+    metadata.provides_battery = pHMD->GetBoolTrackedDeviceProperty(i, vr::Prop_DeviceProvidesBatteryStatus_Bool);
+    if (metadata.provides_battery) {
+        metadata.battery = pHMD->GetFloatTrackedDeviceProperty(i, vr::Prop_DeviceBatteryPercentage_Float);
+        metadata.charging = pHMD->GetBoolTrackedDeviceProperty(i, vr::Prop_DeviceIsCharging_Bool);
+    }
+    return true;
+}
@@ -0,0 +1,75 @@
+#include "property_poller.hpp"
+#include <cmath>
+#include <cstring>
+
+#include "VRUtils.hpp"
+
+PropertyPoller::PropertyPoller(PoseSource& source, DeviceMetadataTable& table, std::chrono::milliseconds period)
+    : source(source), table(table), period(period) {
+}
+
+PropertyPoller::~PropertyPoller() {
+    stop();
+}
+
+void PropertyPoller::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    running = true;
+    thread = std::thread(&PropertyPoller::run, this);
+}
+
+void PropertyPoller::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void PropertyPoller::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        lock.unlock();
+        if (refresh() && on_change) {
+            on_change();
+        }
+        lock.lock();
+        cv.wait_for(lock, period, [this] { return !running; });
+    }
+}
+
+// Store the devices whose metadata changed, true if any did
+bool PropertyPoller::refresh() {
+    // The source's liveness check blocks on IPC like the property queries
+    source.probe();
+    bool changed = false;
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        DeviceMetadata current;
+        std::memset(&current, 0, sizeof(current));
+        if (source.getDeviceMetadata(i, current)) {
+            current.connected = true;
+            // Battery readings are reported in percent steps, ignore float noise
+            current.battery = std::round(current.battery * 100.0f) / 100.0f;
+        }
+
+        DeviceMetadata cached;
+        uint64_t version = table.load(i, cached);
+        if (version == 0 ? !current.connected : std::memcmp(&current, &cached, sizeof(current)) == 0) {
+            continue;
+        }
+        table.store(i, current);
+        changed = true;
+        if (current.connected != (version != 0 && cached.connected)) {
+            VIVE_LOG(Info, "Device %u %s: %s %s, firmware %s", i, current.connected ? "connected" : "disconnected",
+                     current.connected ? current.model : cached.model, current.connected ? current.serial : cached.serial,
+                     current.connected ? current.firmware : cached.firmware);
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,175 @@
+#include "realtime.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "VRUtils.hpp"
+
+// Per-thread allocation counter fed by the global operator new below,
+// the over-aligned overloads included (VRControllerData is alignas(64))
+static thread_local uint64_t thread_allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++thread_allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    ++thread_allocations;
+    // aligned_alloc wants a multiple of the alignment
+    std::size_t align = static_cast<std::size_t>(alignment);
+    void* p = std::aligned_alloc(align, ((size ? size : 1) + align - 1) & ~(align - 1));
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+bool RealtimeUtils::lockMemory() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        VIVE_LOG(Warning, "mlockall failed: %s", std::strerror(errno));
+        return false;
+    }
+    VIVE_LOG(Info, "Process memory locked");
+    return true;
+}
+
+bool RealtimeUtils::configureThread(const RealtimeConfig& config, const std::string& name) {
+    bool ok = true;
+    if (config.priority > 0) {
+        sched_param param{};
+        param.sched_priority = config.priority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            VIVE_LOG(Warning, "%s: SCHED_FIFO priority %d failed: %s", name.c_str(), config.priority, std::strerror(err));
+            ok = false;
+        } else {
+            VIVE_LOG(Info, "%s: SCHED_FIFO priority %d", name.c_str(), config.priority);
+        }
+    }
+    if (config.cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(config.cpu, &cpuset);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        if (err != 0) {
+            VIVE_LOG(Warning, "%s: pinning to CPU %d failed: %s", name.c_str(), config.cpu, std::strerror(err));
+            ok = false;
+        } else {
+            VIVE_LOG(Info, "%s: pinned to CPU %d", name.c_str(), config.cpu);
+        }
+    }
+    if (config.priority > 0 || config.cpu >= 0) {
+        prefaultStack();
+    }
+    return ok;
+}
+
+void RealtimeUtils::prefaultStack() {
+    constexpr size_t kStackPrefaultSize = 256 * 1024;
+    volatile unsigned char stack[kStackPrefaultSize];
+    for (size_t i = 0; i < kStackPrefaultSize; i += 4096) {
+        stack[i] = 0;
+    }
+    (void)stack;
+}
+
+uint64_t RealtimeUtils::threadAllocationCount() {
+    return thread_allocations;
+}
+
+LoopStats::LoopStats(const std::string& name, std::chrono::microseconds nominal_period, std::chrono::seconds report_interval)
+    : name(name), nominal_period(nominal_period), report_interval(report_interval) {}
+
+void LoopStats::tick() {
+    Clock::time_point now = Clock::now();
+    uint64_t current_allocations = RealtimeUtils::threadAllocationCount();
+
+    if (!running) {
+        // (Re)start measuring, the first interval after an idle phase is not meaningful
+        running = true;
+        last_tick = now;
+        last_allocations = current_allocations;
+        if (iterations == 0) {
+            window_start = now;
+        }
+        return;
+    }
+
+    double period_us = std::chrono::duration<double, std::micro>(now - last_tick).count();
+    iterations++;
+    sum_us += period_us;
+    if (period_us > max_us) {
+        max_us = period_us;
+    }
+    if (period_us > 2.0 * nominal_period.count()) {
+        stalls++;
+    }
+    // Allocations of the first window are startup, not hot path
+    if (warmed_up) {
+        allocations += current_allocations - last_allocations;
+    }
+    last_tick = now;
+    last_allocations = current_allocations;
+
+    if (report_interval.count() > 0 && now - window_start >= report_interval) {
+        report(now);
+    }
+}
+
+void LoopStats::report(Clock::time_point now) {
+    double window_s = std::chrono::duration<double>(now - window_start).count();
+    VIVE_LOG(Info, "[%s STATS] %llu iterations in %f s, mean period %f us, max %f us, stalls (>%lld us) %llu",
+             name.c_str(), (unsigned long long)iterations, window_s, iterations ? sum_us / iterations : 0.0, max_us,
+             (long long)(2 * nominal_period.count()), (unsigned long long)stalls);
+    if (check_allocations && warmed_up && allocations > 0) {
+        VIVE_LOG(Warning, "[%s STATS] hot path made %llu heap allocations", name.c_str(), (unsigned long long)allocations);
+    }
+
+    warmed_up = true;
+    window_start = now;
+    iterations = 0;
+    stalls = 0;
+    allocations = 0;
+    sum_us = 0.0;
+    max_us = 0.0;
+    // Do not charge the report itself to the hot path
+    last_allocations = RealtimeUtils::threadAllocationCount();
+}
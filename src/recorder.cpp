@@ -0,0 +1,252 @@
+#include "recorder.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "VRUtils.hpp"
+
+Recorder::~Recorder() {
+    close();
+}
+
+bool Recorder::open(const std::string& file_path, size_t max_bytes) {
+    close();
+    path = file_path;
+
+    capacity = max_bytes > kRecordingHeaderSize ? (max_bytes - kRecordingHeaderSize) / sizeof(RecordedSample) : 0;
+    if (capacity == 0) {
+        VIVE_LOG(Error, "Recording size too small: %zu bytes", max_bytes);
+        return false;
+    }
+    // Chunks are a power of two records, large enough for the index to cover the file
+    uint32_t chunk_records = 1024;
+    while (static_cast<uint64_t>(chunk_records) * kRecordingMaxChunks < capacity) {
+        chunk_records *= 2;
+    }
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        VIVE_LOG(Error, "Cannot open recording %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    mapped_size = kRecordingHeaderSize + capacity * sizeof(RecordedSample);
+    // Not every file system supports fallocate; a sparse file still works, so only the fallback's error counts
+    if (posix_fallocate(fd, 0, mapped_size) != 0 && ftruncate(fd, mapped_size) != 0) {
+        VIVE_LOG(Error, "Cannot preallocate %zu bytes for %s: %s", mapped_size, path.c_str(), std::strerror(errno));
+        close();
+        return false;
+    }
+    void* p = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        VIVE_LOG(Error, "Cannot map recording %s: %s", path.c_str(), std::strerror(errno));
+        mapping = nullptr;
+        close();
+        return false;
+    }
+    mapping = static_cast<uint8_t*>(p);
+    madvise(mapping, mapped_size, MADV_SEQUENTIAL);
+
+    header = reinterpret_cast<RecordingHeader*>(mapping);
+    samples = reinterpret_cast<RecordedSample*>(mapping + kRecordingHeaderSize);
+    std::memset(header, 0, kRecordingHeaderSize);
+    std::memcpy(header->magic, kRecordingMagic, sizeof(header->magic));
+    header->version = kRecordingVersion;
+    header->header_size = kRecordingHeaderSize;
+    header->record_size = sizeof(RecordedSample);
+    header->chunk_records = chunk_records;
+    header->max_chunks = kRecordingMaxChunks;
+    header->start_wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header->start_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    full_reported = false;
+
+    // Fault in the first chunk now rather than on the hot path
+    madvise(samples, std::min<size_t>(chunk_records * sizeof(RecordedSample), capacity * sizeof(RecordedSample)), MADV_WILLNEED);
+    chunks_started.store(0, std::memory_order_relaxed);
+    writeback_running.store(true, std::memory_order_relaxed);
+    writeback = std::thread([this]() { writebackLoop(); });
+
+    VIVE_LOG(Info, "Recording to %s (up to %llu samples)", path.c_str(), static_cast<unsigned long long>(capacity));
+    return true;
+}
+
+void Recorder::close() {
+    writeback_running.store(false, std::memory_order_relaxed);
+    if (writeback.joinable()) {
+        writeback.join();
+    }
+    if (mapping) {
+        uint64_t count = header->record_count;
+        size_t used = kRecordingHeaderSize + count * sizeof(RecordedSample);
+        msync(mapping, used, MS_SYNC);
+        munmap(mapping, mapped_size);
+        if (ftruncate(fd, used) != 0) {
+            VIVE_LOG(Warning, "Cannot trim recording %s: %s", path.c_str(), std::strerror(errno));
+        }
+        VIVE_LOG(Info, "Recording %s closed with %llu samples", path.c_str(), static_cast<unsigned long long>(count));
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd = -1;
+    mapping = nullptr;
+    header = nullptr;
+    samples = nullptr;
+    mapped_size = 0;
+}
+
+RecordedSample* Recorder::beginSample() {
+    if (!header) {
+        return nullptr;
+    }
+    if (header->record_count >= capacity) {
+        if (!full_reported) {
+            VIVE_LOG(Warning, "Recording %s is full, further samples are not recorded", path.c_str());
+            full_reported = true;
+        }
+        return nullptr;
+    }
+    return &samples[header->record_count];
+}
+
+void Recorder::commitSample() {
+    uint64_t index = header->record_count;
+    const RecordedSample& sample = samples[index];
+    uint32_t chunk = static_cast<uint32_t>(index / header->chunk_records);
+
+    RecordingChunk& entry = header->chunks[chunk];
+    if (index % header->chunk_records == 0) {
+        entry.first_record = index;
+        entry.first_time_ns = sample.time_ns;
+        header->chunk_count = chunk + 1;
+        // Write-back and read-ahead are left to writebackLoop()
+        chunks_started.store(chunk + 1, std::memory_order_release);
+    }
+    entry.last_time_ns = sample.time_ns;
+    entry.record_count++;
+    header->record_count = index + 1;
+}
+
+// Polls like the async logger's drain thread, so the acquisition thread
+// never has to wake it. When chunk k has started, chunk k - 1 is complete:
+// start its write-back and read ahead chunk k + 1.
+void Recorder::writebackLoop() {
+    const size_t chunk_bytes = static_cast<size_t>(header->chunk_records) * sizeof(RecordedSample);
+    uint32_t handled = 0;
+    while (writeback_running.load(std::memory_order_relaxed)) {
+        uint32_t started = chunks_started.load(std::memory_order_acquire);
+        for (; handled < started; handled++) {
+            uint64_t first = static_cast<uint64_t>(handled) * header->chunk_records;
+            if (handled > 0) {
+                off_t offset = kRecordingHeaderSize + (first - header->chunk_records) * sizeof(RecordedSample);
+                sync_file_range(fd, offset, chunk_bytes, SYNC_FILE_RANGE_WRITE);
+            }
+            uint64_t next = first + header->chunk_records;
+            if (next < capacity) {
+                madvise(&samples[next], std::min<size_t>(chunk_bytes, (capacity - next) * sizeof(RecordedSample)), MADV_WILLNEED);
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+void Recorder::record(int64_t time_ns, uint32_t frame, vr::TrackedDeviceIndex_t device, vr::ETrackedDeviceClass device_class,
+                      vr::ETrackedControllerRole role, const vr::TrackedDevicePose_t& pose, const vr::VRControllerState_t* state) {
+    RecordedSample* sample = beginSample();
+    if (!sample) {
+        return;
+    }
+    sample->time_ns = time_ns;
+    sample->frame = frame;
+    sample->device = static_cast<uint8_t>(device);
+    sample->device_class = static_cast<uint8_t>(device_class);
+    sample->role = static_cast<uint8_t>(role);
+    sample->flags = (pose.bDeviceIsConnected ? SampleConnected : 0) | (pose.bPoseIsValid ? SamplePoseValid : 0) |
+                    (state ? SampleHasInput : 0);
+    sample->tracking_result = static_cast<uint16_t>(pose.eTrackingResult);
+    sample->reserved0 = 0;
+    std::memcpy(sample->matrix, pose.mDeviceToAbsoluteTracking.m, sizeof(sample->matrix));
+    std::memcpy(sample->velocity, pose.vVelocity.v, sizeof(sample->velocity));
+    std::memcpy(sample->angular_velocity, pose.vAngularVelocity.v, sizeof(sample->angular_velocity));
+    sample->reserved1 = 0;
+    sample->buttons_pressed = state ? state->ulButtonPressed : 0;
+    sample->buttons_touched = state ? state->ulButtonTouched : 0;
+    sample->trackpad[0] = state ? state->rAxis[0].x : 0.0f;
+    sample->trackpad[1] = state ? state->rAxis[0].y : 0.0f;
+    sample->trigger = state ? state->rAxis[1].x : 0.0f;
+    sample->reserved2 = 0;
+    commitSample();
+}
+
+RecordingReader::~RecordingReader() {
+    close();
+}
+
+bool RecordingReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        VIVE_LOG(Error, "Cannot open recording %s: %s", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kRecordingHeaderSize) {
+        VIVE_LOG(Error, "%s is not a recording", path.c_str());
+        ::close(fd);
+        return false;
+    }
+    mapped_size = st.st_size;
+    void* p = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        VIVE_LOG(Error, "Cannot map recording %s: %s", path.c_str(), std::strerror(errno));
+        mapped_size = 0;
+        return false;
+    }
+    mapping = static_cast<uint8_t*>(p);
+    madvise(mapping, mapped_size, MADV_SEQUENTIAL);
+
+    header_ = reinterpret_cast<const RecordingHeader*>(mapping);
+    if (std::memcmp(header_->magic, kRecordingMagic, sizeof(header_->magic)) != 0 ||
+        header_->version != kRecordingVersion || header_->header_size != kRecordingHeaderSize ||
+        header_->record_size != sizeof(RecordedSample) || header_->chunk_records == 0) {
+        VIVE_LOG(Error, "%s is not a version %u recording", path.c_str(), kRecordingVersion);
+        close();
+        return false;
+    }
+    samples_ = reinterpret_cast<const RecordedSample*>(mapping + kRecordingHeaderSize);
+    count_ = std::min<uint64_t>(header_->record_count, (mapped_size - kRecordingHeaderSize) / sizeof(RecordedSample));
+    return true;
+}
+
+void RecordingReader::close() {
+    if (mapping) {
+        munmap(mapping, mapped_size);
+    }
+    mapping = nullptr;
+    mapped_size = 0;
+    header_ = nullptr;
+    samples_ = nullptr;
+    count_ = 0;
+}
+
+uint64_t RecordingReader::findTime(int64_t time_ns) const {
+    // Last chunk starting at or before time_ns, then scan within it
+    // The header of a damaged file may claim more chunks than fit in it
+    uint32_t chunk_count = std::min({header_->chunk_count, header_->max_chunks, kRecordingMaxChunks});
+    const RecordingChunk* begin = header_->chunks;
+    const RecordingChunk* end = header_->chunks + chunk_count;
+    const RecordingChunk* chunk = std::upper_bound(begin, end, time_ns,
+        [](int64_t t, const RecordingChunk& c) { return t < c.first_time_ns; });
+    uint64_t index = chunk == begin ? 0 : (chunk - 1)->first_record;
+    while (index < count_ && samples_[index].time_ns < time_ns) {
+        index++;
+    }
+    return index;
+}
@@ -0,0 +1,136 @@
+#include "replay_pose_source.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "VRUtils.hpp"
+
+ReplayPoseSource::ReplayPoseSource(const ReplayConfig& config)
+    : config(config) {
+    std::memset(poses, 0, sizeof(poses));
+    std::memset(states, 0, sizeof(states));
+}
+
+bool ReplayPoseSource::init() {
+    if (!reader.open(config.path)) {
+        return false;
+    }
+    if (reader.count() == 0) {
+        VIVE_LOG(Error, "Recording %s is empty", config.path.c_str());
+        return false;
+    }
+    const RecordedSample* s = reader.samples();
+    int64_t begin_ns = s[0].time_ns;
+    double duration = (s[reader.count() - 1].time_ns - begin_ns) * 1e-9;
+    first = reader.findTime(begin_ns + static_cast<int64_t>(config.seek * 1e9));
+    if (first >= reader.count()) {
+        VIVE_LOG(Error, "Seek to %.3f s is past the end of %s (%.3f s)", config.seek, config.path.c_str(), duration);
+        return false;
+    }
+    VIVE_LOG(Info, "Replaying %s: %llu samples, %.3f s, from %.3f s at %s", config.path.c_str(),
+             static_cast<unsigned long long>(reader.count()), duration, (s[first].time_ns - begin_ns) * 1e-9,
+             config.speed > 0.0 ? std::to_string(config.speed).c_str() : "full speed");
+    started = Clock::now();
+    rewind();
+    return true;
+}
+
+void ReplayPoseSource::shutdown() {
+    if (frames > 0) {
+        double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+        VIVE_LOG(Info, "Replayed %llu frames (%llu samples) in %.3f s: %.0f frames/s, %.0f samples/s",
+                 static_cast<unsigned long long>(frames), static_cast<unsigned long long>(samples), elapsed,
+                 frames / elapsed, samples / elapsed);
+    }
+    frames = samples = 0;
+    reader.close();
+}
+
+void ReplayPoseSource::rewind() {
+    cursor = first;
+    base_wall = Clock::now();
+    base_time_ns = reader.samples()[first].time_ns;
+}
+
+void ReplayPoseSource::getPoses(vr::TrackedDevicePose_t* out, uint32_t count) {
+    if (cursor >= reader.count()) {
+        if (!config.loop) {
+            done = true;
+            std::memset(out, 0, count * sizeof(vr::TrackedDevicePose_t));
+            return;
+        }
+        // The poses jump back to the start of the recording: one frame with
+        // every device disconnected, so ViveInput drops the state it keeps per
+        // device (jump check, filter, dead reckoning) instead of carrying it over
+        rewind();
+        for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+            poses[i].bDeviceIsConnected = false;
+            poses[i].bPoseIsValid = false;
+            has_input[i] = false;
+        }
+        std::memset(out, 0, count * sizeof(vr::TrackedDevicePose_t));
+        return;
+    }
+
+    // The samples of one frame are contiguous and share a timestamp
+    const RecordedSample* s = reader.samples();
+    const RecordedSample& head = s[cursor];
+    if (config.speed > 0.0) {
+        auto offset = std::chrono::duration<double>((head.time_ns - base_time_ns) * 1e-9 / config.speed);
+        std::this_thread::sleep_until(base_wall + std::chrono::duration_cast<Clock::duration>(offset));
+    }
+
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        poses[i].bDeviceIsConnected = false;
+        poses[i].bPoseIsValid = false;
+        has_input[i] = false;
+    }
+    for (; cursor < reader.count() && s[cursor].frame == head.frame; cursor++) {
+        const RecordedSample& sample = s[cursor];
+        if (sample.device >= vr::k_unMaxTrackedDeviceCount) {
+            continue;
+        }
+        vr::TrackedDevicePose_t& pose = poses[sample.device];
+        pose.bDeviceIsConnected = (sample.flags & SampleConnected) != 0;
+        pose.bPoseIsValid = (sample.flags & SamplePoseValid) != 0;
+        pose.eTrackingResult = static_cast<vr::ETrackingResult>(sample.tracking_result);
+        std::memcpy(pose.mDeviceToAbsoluteTracking.m, sample.matrix, sizeof(sample.matrix));
+        std::memcpy(pose.vVelocity.v, sample.velocity, sizeof(sample.velocity));
+        std::memcpy(pose.vAngularVelocity.v, sample.angular_velocity, sizeof(sample.angular_velocity));
+        device_class[sample.device] = sample.device_class;
+        role[sample.device] = sample.role;
+
+        has_input[sample.device] = (sample.flags & SampleHasInput) != 0;
+        vr::VRControllerState_t& state = states[sample.device];
+        state.unPacketNum = sample.frame;
+        state.ulButtonPressed = sample.buttons_pressed;
+        state.ulButtonTouched = sample.buttons_touched;
+        state.rAxis[0].x = sample.trackpad[0];
+        state.rAxis[0].y = sample.trackpad[1];
+        state.rAxis[1].x = sample.trigger;
+        samples++;
+    }
+    frames++;
+    std::memcpy(out, poses, std::min(count, vr::k_unMaxTrackedDeviceCount) * sizeof(vr::TrackedDevicePose_t));
+}
+
+vr::ETrackedDeviceClass ReplayPoseSource::getDeviceClass(vr::TrackedDeviceIndex_t i) {
+    return i < vr::k_unMaxTrackedDeviceCount ? static_cast<vr::ETrackedDeviceClass>(device_class[i]) : vr::TrackedDeviceClass_Invalid;
+}
+
+vr::ETrackedControllerRole ReplayPoseSource::getControllerRole(vr::TrackedDeviceIndex_t i) {
+    return i < vr::k_unMaxTrackedDeviceCount ? static_cast<vr::ETrackedControllerRole>(role[i]) : vr::TrackedControllerRole_Invalid;
+}
+
+bool ReplayPoseSource::getControllerStateWithPose(vr::TrackedDeviceIndex_t i, vr::VRControllerState_t* state, vr::TrackedDevicePose_t* pose) {
+    if (i >= vr::k_unMaxTrackedDeviceCount || !has_input[i]) {
+        return false;
+    }
+    *state = states[i];
+    *pose = poses[i];
+    return true;
+}
+
+bool ReplayPoseSource::pollNextEvent(vr::VREvent_t*) {
+    return false;
+}
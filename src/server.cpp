@@ -1,22 +1,22 @@
 #include "server.hpp"
 #include <iostream>
-#include <sstream>
-#include <iomanip>
-#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
 #include <unistd.h> // For close()
 
-Server::Server(int port, std::mutex &mutex, std::condition_variable &cv, VRControllerData &data) 
-    : data_mutex(mutex), data_cv(cv), shared_data(data) {
+Server::Server(int port, std::mutex &mutex, std::condition_variable &cv, TrackerSampleSlots &samples)
+    : data_mutex(mutex), data_cv(cv), shared_samples(samples) {
     signal(SIGPIPE, SIG_IGN); // Ignore SIGPIPE signals
 
     if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
-        perror("socket failed");
+        VIVE_LOG(Error, "socket failed: %s", std::strerror(errno));
         exit(EXIT_FAILURE);
     }
 
     int reuse = 1;
     if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &reuse, sizeof(opt))) {
-        perror("setsockopt");
+        VIVE_LOG(Error, "setsockopt: %s", std::strerror(errno));
         exit(EXIT_FAILURE);
     }
 
@@ -25,7 +25,12 @@ Server::Server(int port, std::mutex &mutex, std::condition_variable &cv, VRContr
     address.sin_port = htons(port);
 
     if (bind(server_fd, (struct sockaddr *)&address, sizeof(address))<0) {
-        perror("bind failed");
+        VIVE_LOG(Error, "bind failed: %s", std::strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    if (listen(server_fd, 3) < 0) {
+        VIVE_LOG(Error, "listen: %s", std::strerror(errno));
         exit(EXIT_FAILURE);
     }
 }
@@ -38,56 +43,288 @@ Server::~Server() {
 }
 
 void Server::start() {
-    if (listen(server_fd, 3) < 0) {
-        perror("listen");
-        exit(EXIT_FAILURE);
-    }
+    RealtimeUtils::configureThread(rt_config, "Server");
+    // No allocation check: every message is formatted into a std::string
+    LoopStats stats("SERVER", expected_period, std::chrono::seconds(10));
 
-    std::cout << "Server listening on port " << ntohs(address.sin_port) << std::endl;
+    VIVE_LOG(Info, "Server listening on port %d", ntohs(address.sin_port));
 
     int addrlen = sizeof(address);
     while (true) {
-        std::cout << "Waiting for new connection..." << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(data_mutex);
+            if (!running) {
+                return;
+            }
+        }
+        VIVE_LOG(Info, "Waiting for new connection...");
         int new_socket;
         if ((new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t*)&addrlen))<0) {
-            perror("accept");
+            if (errno == EBADF || errno == EINVAL) {
+                return; // Listening socket was closed, server is shutting down
+            }
+            VIVE_LOG(Error, "accept: %s", std::strerror(errno));
             continue; // Continue to accept next connection
         }
 
-        std::cout << "Connection established." << std::endl;
-        while (true) {
-            json data = prepareData();
-            std::string message = data.dump();
+        VIVE_LOG(Info, "Connection established.");
+        {
+            // A new client gets every known base station once
+            std::lock_guard<std::mutex> lock(data_mutex);
+            pending_references |= known_references;
+            pending_status = status_known;
+            sent_metadata_changes = 0;
+            std::fill(std::begin(sent_metadata_version), std::end(sent_metadata_version), 0);
+        }
+        std::string message;
+        while (prepareMessages(message)) {
             if (send(new_socket, message.c_str(), message.length(), 0) == -1) {
-                perror("send");
-                close(new_socket);
+                VIVE_LOG(Error, "send: %s", std::strerror(errno));
                 break; // Exit the inner loop to wait for a new connection
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(2));  // 500Hz
+            stats.tick(); // Paced by the VR loop through prepareData()
+        }
+        close(new_socket);
+        stats.pause();
+    }
+}
+
+void Server::stop() {
+    {
+        std::lock_guard<std::mutex> lock(data_mutex);
+        running = false;
+    }
+    data_cv.notify_all();
+    shutdown(server_fd, SHUT_RDWR); // Wakes up accept()
+}
+
+void Server::publishTrackingReference(const TrackingReferenceData &data) {
+    if (data.index >= vr::k_unMaxTrackedDeviceCount) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(data_mutex);
+        references[data.index] = data;
+        uint64_t bit = uint64_t(1) << data.index;
+        if (data.valid) {
+            known_references |= bit;
+        } else {
+            known_references &= ~bit;
+        }
+        pending_references |= bit;
+    }
+    data_cv.notify_one();
+}
+
+void Server::publishRelativePoses(const RelativePoseData *poses, uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(data_mutex);
+        for (uint32_t k = 0; k < count; k++) {
+            if (poses[k].device < vr::k_unMaxTrackedDeviceCount) {
+                relative_poses[poses[k].device] = poses[k];
+                pending_relative |= uint64_t(1) << poses[k].device;
+            }
         }
     }
+    data_cv.notify_one();
+}
+
+void Server::publishStatus(const char *source, bool available) {
+    {
+        std::lock_guard<std::mutex> lock(data_mutex);
+        status_known = true;
+        status_available = available;
+        status_source = source;
+        pending_status = true;
+    }
+    data_cv.notify_one();
+}
+
+void Server::publishTrackingQuality(const TrackingQuality *results, uint32_t count, double window) {
+    {
+        std::lock_guard<std::mutex> lock(data_mutex);
+        tracking_quality_count = std::min(count, vr::k_unMaxTrackedDeviceCount);
+        std::copy(results, results + tracking_quality_count, tracking_quality);
+        tracking_quality_window = window;
+        pending_quality = true;
+    }
+    data_cv.notify_one();
+}
+
+void Server::notifyDeviceMetadata() {
+    {
+        // Taking the lock orders this with the predicate check in prepareMessages()
+        std::lock_guard<std::mutex> lock(data_mutex);
+    }
+    data_cv.notify_one();
 }
 
-json Server::prepareData() {
+// Newline-delimited JSON messages, each with a "type"
+bool Server::prepareMessages(std::string &out) {
     std::unique_lock<std::mutex> lock(data_mutex);
-    data_cv.wait(lock); // Wait for new data
+    // Wait for new data
+    data_cv.wait(lock, [this] {
+        return !running || pending_status || pending_quality || pending_references != 0 || pending_relative != 0 ||
+               shared_samples.pending != 0 ||
+               (metadata && metadata->changeCount() != sent_metadata_changes);
+    });
+    if (!running) {
+        return false;
+    }
+
+    out.clear();
+    if (pending_status) {
+        appendStatusMessage(out);
+        pending_status = false;
+    }
+    for (uint32_t i = 0; pending_references != 0 && i < vr::k_unMaxTrackedDeviceCount; i++) {
+        uint64_t bit = uint64_t(1) << i;
+        if (pending_references & bit) {
+            appendReferenceMessage(references[i], out);
+            pending_references &= ~bit;
+        }
+    }
+    if (pending_quality) {
+        appendQualityMessage(out);
+        pending_quality = false;
+    }
+    if (metadata && metadata->changeCount() != sent_metadata_changes) {
+        appendMetadataMessages(out);
+    }
+    // The tracker samples and the relative poses are copied out and formatted after the lock is released
+    VRControllerData trackers[vr::k_unMaxTrackedDeviceCount];
+    uint32_t tracker_count = 0;
+    for (uint32_t i = 0; shared_samples.pending != 0 && i < vr::k_unMaxTrackedDeviceCount; i++) {
+        uint64_t bit = uint64_t(1) << i;
+        if (shared_samples.pending & bit) {
+            trackers[tracker_count++] = shared_samples.latest[i];
+            shared_samples.pending &= ~bit;
+        }
+    }
+    RelativePoseData relative[vr::k_unMaxTrackedDeviceCount];
+    uint32_t relative_count = 0;
+    for (uint32_t i = 0; pending_relative != 0 && i < vr::k_unMaxTrackedDeviceCount; i++) {
+        uint64_t bit = uint64_t(1) << i;
+        if (pending_relative & bit) {
+            relative[relative_count++] = relative_poses[i];
+            pending_relative &= ~bit;
+        }
+    }
+    lock.unlock();
+    for (uint32_t k = 0; k < tracker_count; k++) {
+        appendTrackerMessage(trackers[k], out);
+    }
+    for (uint32_t k = 0; k < relative_count; k++) {
+        appendRelativeMessage(relative[k], out);
+    }
+    return true;
+}
+
+void Server::appendTrackerMessage(const VRControllerData &data, std::string &out) {
+    json j;
+    j["type"] = "tracker";
+    j["device"] = data.device;
+    j["pose"] = {{"x", data.pose_x}, {"y", data.pose_y}, {"z", data.pose_z}, {"qx", data.pose_qx}, {"qy", data.pose_qy}, {"qz", data.pose_qz}, {"qw", data.pose_qw}};
+    j["raw_pose"] = {{"x", data.raw_x}, {"y", data.raw_y}, {"z", data.raw_z}, {"qx", data.raw_qx}, {"qy", data.raw_qy}, {"qz", data.raw_qz}, {"qw", data.raw_qw}};
+    j["velocity"] = {{"x", data.vel_x}, {"y", data.vel_y}, {"z", data.vel_z}};
+    j["angular_velocity"] = {{"x", data.ang_vel_x}, {"y", data.ang_vel_y}, {"z", data.ang_vel_z}};
+    j["buttons"] = {{"menu", (data.buttons & ButtonMenu) != 0}, {"trigger", (data.buttons & ButtonTrigger) != 0},
+                    {"trackpad_touch", (data.buttons & ButtonTrackpadTouch) != 0}, {"trackpad_button", (data.buttons & ButtonTrackpad) != 0},
+                    {"grip", (data.buttons & ButtonGrip) != 0}};
+    j["trackpad"] = {{"x", data.trackpad_x}, {"y", data.trackpad_y}};
+    j["trigger"] = data.trigger;
+    j["edges"] = {{"pressed", data.pressed_edges}, {"released", data.released_edges}};
+    j["role"] = data.role;
+    j["predicted"] = (data.flags & TrackerPredicted) != 0;
+    j["time"] = VRUtils::formatTime(data.time_ns);
+    j["time_ns"] = data.time_ns;
+    out += j.dump();
+    out += '\n';
+}
 
+void Server::appendReferenceMessage(const TrackingReferenceData &data, std::string &out) {
     json j;
-    j["pose"] = {{"x", shared_data.pose_x}, {"y", shared_data.pose_y}, {"z", shared_data.pose_z}, {"qx", shared_data.pose_qx}, {"qy", shared_data.pose_qy}, {"qz", shared_data.pose_qz}, {"qw", shared_data.pose_qw}};
-    j["buttons"] = {{"menu", shared_data.menu_button}, {"trigger", shared_data.trigger_button}, {"trackpad_touch", shared_data.trackpad_touch}, {"trackpad_button", shared_data.trackpad_button}, {"grip", shared_data.grip_button}};
-    j["trackpad"] = {{"x", shared_data.trackpad_x}, {"y", shared_data.trackpad_y}};
-    j["trigger"] = shared_data.trigger;
-    j["role"] = shared_data.role;
-    j["time"] = shared_data.time;
-    return j;
+    j["type"] = "tracking_reference";
+    j["index"] = data.index;
+    j["serial"] = data.serial;
+    j["valid"] = data.valid;
+    j["pose"] = {{"x", data.pose_x}, {"y", data.pose_y}, {"z", data.pose_z}, {"qx", data.pose_qx}, {"qy", data.pose_qy}, {"qz", data.pose_qz}, {"qw", data.pose_qw}};
+    j["time"] = data.time;
+    j["time_ns"] = data.time_ns;
+    out += j.dump();
+    out += '\n';
+}
+
+void Server::appendRelativeMessage(const RelativePoseData &data, std::string &out) {
+    json j;
+    j["type"] = "relative_pose";
+    j["device"] = data.device;
+    j["reference"] = data.reference;
+    j["pose"] = {{"x", data.pose_x}, {"y", data.pose_y}, {"z", data.pose_z}, {"qx", data.pose_qx}, {"qy", data.pose_qy}, {"qz", data.pose_qz}, {"qw", data.pose_qw}};
+    j["predicted"] = (data.flags & TrackerPredicted) != 0;
+    j["time"] = VRUtils::formatTime(data.time_ns);
+    j["time_ns"] = data.time_ns;
+    out += j.dump();
+    out += '\n';
+}
+
+void Server::appendStatusMessage(std::string &out) {
+    json j;
+    j["type"] = "status";
+    j["source"] = status_source;
+    j["available"] = status_available;
+    j["time"] = getCurrentTimeWithMilliseconds();
+    out += j.dump();
+    out += '\n';
+}
+
+void Server::appendQualityMessage(std::string &out) {
+    json j;
+    j["type"] = "tracking_quality";
+    j["window"] = tracking_quality_window;
+    json devices = json::array();
+    for (uint32_t k = 0; k < tracking_quality_count; k++) {
+        const TrackingQuality &q = tracking_quality[k];
+        json states = json::object();
+        for (int s = 0; s < kTrackingStateCount; s++) {
+            states[trackingStateName(s)] = {{"count", q.counts[s]}, {"duration", q.durations[s]}};
+        }
+        devices.push_back({{"index", q.index}, {"device_class", q.device_class}, {"samples", q.samples},
+                           {"valid_rate", q.valid_rate}, {"valid_fraction", q.valid_fraction},
+                           {"longest_gap", q.longest_gap}, {"states", states}});
+    }
+    j["devices"] = devices;
+    out += j.dump();
+    out += '\n';
+}
+
+void Server::appendMetadataMessages(std::string &out) {
+    sent_metadata_changes = metadata->changeCount();
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        if (metadata->version(i) == sent_metadata_version[i]) {
+            continue;
+        }
+        DeviceMetadata device;
+        sent_metadata_version[i] = metadata->load(i, device);
+        json j;
+        j["type"] = "device_metadata";
+        j["index"] = i;
+        j["connected"] = device.connected;
+        j["device_class"] = device.device_class;
+        j["serial"] = device.serial;
+        j["model"] = device.model;
+        j["firmware"] = device.firmware;
+        j["provides_battery"] = device.provides_battery;
+        j["battery"] = device.battery;
+        j["charging"] = device.charging;
+        out += j.dump();
+        out += '\n';
+    }
 }
 
 std::string Server::getCurrentTimeWithMilliseconds() {
-    auto now = std::chrono::system_clock::now();
-    auto nowAsTimeT = std::chrono::system_clock::to_time_t(now);
-    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&nowAsTimeT), "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << nowMs.count();
-    return ss.str();
-}
\ No newline at end of file
+    return VRUtils::formatTime(VRUtils::wallTimeNs());
+}
@@ -0,0 +1,185 @@
+#include "synthetic_pose_source.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "VRUtils.hpp"
+
+using Rotation = transform::Quaternion<double>;
+
+bool SyntheticConfig::parseTrajectory(const std::string& name, Trajectory& trajectory) {
+    if (name == "static") {
+        trajectory = Static;
+    } else if (name == "circle") {
+        trajectory = Circle;
+    } else if (name == "figure8") {
+        trajectory = Figure8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+SyntheticPoseSource::SyntheticPoseSource(const SyntheticConfig& config)
+    : config(config), rng(config.seed) {
+    this->config.devices = std::min(config.devices, vr::k_unMaxTrackedDeviceCount);
+    this->config.references = std::min(config.references, vr::k_unMaxTrackedDeviceCount - this->config.devices);
+    std::memset(poses, 0, sizeof(poses));
+}
+
+bool SyntheticPoseSource::init() {
+    start_time = Clock::now();
+    last_sample_time = 0.0;
+    VIVE_LOG(Info, "Synthetic pose source: %u devices, %u base stations", config.devices, config.references);
+    return true;
+}
+
+void SyntheticPoseSource::getPoses(vr::TrackedDevicePose_t* out, uint32_t count) {
+    sample_time = std::chrono::duration<double>(Clock::now() - start_time).count();
+    double dt = sample_time - last_sample_time;
+    last_sample_time = sample_time;
+
+    for (uint32_t i = 0; i < config.devices; i++) {
+        generate(i, sample_time, dt);
+    }
+    for (uint32_t i = config.devices; i < config.devices + config.references; i++) {
+        generateReference(i);
+    }
+    std::memcpy(out, poses, std::min(count, vr::k_unMaxTrackedDeviceCount) * sizeof(vr::TrackedDevicePose_t));
+}
+
+vr::ETrackedDeviceClass SyntheticPoseSource::getDeviceClass(vr::TrackedDeviceIndex_t i) {
+    if (i < config.devices) {
+        return vr::TrackedDeviceClass_GenericTracker;
+    }
+    return i < config.devices + config.references ? vr::TrackedDeviceClass_TrackingReference : vr::TrackedDeviceClass_Invalid;
+}
+
+vr::ETrackedControllerRole SyntheticPoseSource::getControllerRole(vr::TrackedDeviceIndex_t) {
+    return vr::TrackedControllerRole_Invalid;
+}
+
+bool SyntheticPoseSource::getControllerStateWithPose(vr::TrackedDeviceIndex_t i, vr::VRControllerState_t* state, vr::TrackedDevicePose_t* pose) {
+    if (i >= config.devices) {
+        return false;
+    }
+    // Trigger held for the first 10% of every 2 s, staggered per device
+    double cycle = std::fmod(sample_time + 0.1 * i, 2.0);
+    bool trigger = cycle < 0.2;
+
+    std::memset(state, 0, sizeof(*state));
+    state->unPacketNum = static_cast<uint32_t>(sample_time * 1000.0);
+    state->ulButtonPressed = trigger ? vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Trigger) : 0;
+    state->rAxis[1].x = trigger ? 1.0f : 0.0f;
+    *pose = poses[i];
+    return true;
+}
+
+bool SyntheticPoseSource::pollNextEvent(vr::VREvent_t*) {
+    return false;
+}
+
+// Trackers drain their battery over two hours, from the poller thread so
+// only the immutable configuration and the clock are used
+bool SyntheticPoseSource::getDeviceMetadata(vr::TrackedDeviceIndex_t i, DeviceMetadata& metadata) {
+    if (i >= config.devices + config.references) {
+        return false;
+    }
+    bool tracker = i < config.devices;
+    uint32_t n = tracker ? i : i - config.devices;
+    metadata.device_class = static_cast<uint8_t>(tracker ? vr::TrackedDeviceClass_GenericTracker : vr::TrackedDeviceClass_TrackingReference);
+    std::snprintf(metadata.serial, sizeof(metadata.serial), tracker ? "SYNTH-%u" : "SYNTH-LHB-%u", n);
+    std::snprintf(metadata.model, sizeof(metadata.model), "%s", tracker ? "Synthetic Tracker" : "Synthetic Base Station");
+    std::snprintf(metadata.firmware, sizeof(metadata.firmware), "synthetic");
+    metadata.provides_battery = tracker;
+    if (tracker) {
+        double elapsed = std::chrono::duration<double>(Clock::now() - start_time).count();
+        metadata.battery = static_cast<float>(std::max(0.0, 1.0 - elapsed / 7200.0));
+    }
+    return true;
+}
+
+void SyntheticPoseSource::generate(uint32_t i, double t, double dt) {
+    vr::TrackedDevicePose_t& pose = poses[i];
+    pose.bDeviceIsConnected = true;
+
+    // Dropouts start as a Poisson process and last dropout_duration
+    if (config.dropout_rate > 0.0 && t >= dropout_until[i] && uniform(rng) < config.dropout_rate * dt) {
+        dropout_until[i] = t + config.dropout_duration;
+    }
+    if (t < dropout_until[i]) {
+        pose.bPoseIsValid = false;
+        pose.eTrackingResult = vr::TrackingResult_Running_OutOfRange;
+        return;
+    }
+    pose.bPoseIsValid = true;
+    pose.eTrackingResult = vr::TrackingResult_Running_OK;
+
+    // Devices are spread along x and out of phase, SteamVR axes (y up)
+    double w = 2.0 * M_PI * config.frequency;
+    double phase = w * t + 2.0 * M_PI * i / std::max(config.devices, 1u);
+    double center[3] = {0.5 * i, 1.0, -0.5};
+    double p[3] = {center[0], center[1], center[2]};
+    double v[3] = {0.0, 0.0, 0.0};
+    double yaw = phase;
+    double yaw_rate = w;
+    switch (config.trajectory) {
+        case SyntheticConfig::Static:
+            yaw = 2.0 * M_PI * i / std::max(config.devices, 1u);
+            yaw_rate = 0.0;
+            break;
+        case SyntheticConfig::Circle:
+            p[0] += config.radius * std::cos(phase);
+            p[2] += config.radius * std::sin(phase);
+            v[0] = -config.radius * w * std::sin(phase);
+            v[2] = config.radius * w * std::cos(phase);
+            break;
+        case SyntheticConfig::Figure8:
+            p[0] += config.radius * std::sin(phase);
+            p[2] += 0.5 * config.radius * std::sin(2.0 * phase);
+            v[0] = config.radius * w * std::cos(phase);
+            v[2] = config.radius * w * std::cos(2.0 * phase);
+            break;
+    }
+
+    // Yaw about y plus small pitch/roll noise: R = Ry(yaw) * Rx(pitch) * Rz(roll)
+    double pitch = config.rotation_noise * gaussian(rng);
+    double roll = config.rotation_noise * gaussian(rng);
+    yaw += config.rotation_noise * gaussian(rng);
+    transform::Matrix3<double> r = (Rotation::fromAxisAngle({0.0, 1.0, 0.0}, yaw) * Rotation::fromAxisAngle({1.0, 0.0, 0.0}, pitch) *
+                                    Rotation::fromAxisAngle({0.0, 0.0, 1.0}, roll)).toMatrix();
+
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            pose.mDeviceToAbsoluteTracking.m[row][col] = static_cast<float>(r.m[row][col]);
+        }
+        pose.mDeviceToAbsoluteTracking.m[row][3] = static_cast<float>(p[row] + config.position_noise * gaussian(rng));
+        pose.vVelocity.v[row] = static_cast<float>(v[row]);
+    }
+    pose.vAngularVelocity.v[0] = 0.0f;
+    pose.vAngularVelocity.v[1] = static_cast<float>(yaw_rate);
+    pose.vAngularVelocity.v[2] = 0.0f;
+}
+
+// Base stations high up in the corners, looking down at the center, with the position noise of the trackers
+void SyntheticPoseSource::generateReference(uint32_t i) {
+    vr::TrackedDevicePose_t& pose = poses[i];
+    uint32_t k = i - config.devices;
+    double yaw = M_PI / 4.0 + M_PI / 2.0 * k;
+    double pitch = -M_PI / 6.0;
+    transform::Matrix3<double> r = (Rotation::fromAxisAngle({0.0, 1.0, 0.0}, yaw) * Rotation::fromAxisAngle({1.0, 0.0, 0.0}, pitch)).toMatrix();
+    double p[3] = {2.0 * std::sin(yaw), 2.2, 2.0 * std::cos(yaw)};
+
+    pose.bDeviceIsConnected = true;
+    pose.bPoseIsValid = true;
+    pose.eTrackingResult = vr::TrackingResult_Running_OK;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            pose.mDeviceToAbsoluteTracking.m[row][col] = static_cast<float>(r.m[row][col]);
+        }
+        pose.mDeviceToAbsoluteTracking.m[row][3] = static_cast<float>(p[row] + config.position_noise * gaussian(rng));
+        pose.vVelocity.v[row] = 0.0f;
+        pose.vAngularVelocity.v[row] = 0.0f;
+    }
+}
@@ -0,0 +1,115 @@
+#include "tracking_stats.hpp"
+#include <algorithm>
+#include <cstring>
+
+#include "VRUtils.hpp"
+
+namespace {
+
+int trackingState(const vr::TrackedDevicePose_t& pose) {
+    switch (pose.eTrackingResult) {
+        case vr::TrackingResult_Calibrating_InProgress:  return StateCalibrating;
+        case vr::TrackingResult_Calibrating_OutOfRange:  return StateCalibratingOutOfRange;
+        case vr::TrackingResult_Running_OK:              return pose.bPoseIsValid ? StateRunningOK : StateInvalidPose;
+        case vr::TrackingResult_Running_OutOfRange:      return StateRunningOutOfRange;
+        case vr::TrackingResult_Fallback_RotationOnly:   return StateRotationOnly;
+        default:                                         return StateUninitialized;
+    }
+}
+
+} // namespace
+
+const char* trackingStateName(int state) {
+    switch (state) {
+        case StateUninitialized:         return "uninitialized";
+        case StateCalibrating:           return "calibrating";
+        case StateCalibratingOutOfRange: return "calibrating_out_of_range";
+        case StateRunningOK:             return "running_ok";
+        case StateRunningOutOfRange:     return "running_out_of_range";
+        case StateRotationOnly:          return "rotation_only";
+        case StateInvalidPose:           return "invalid_pose";
+        default:                         return "unknown";
+    }
+}
+
+TrackingStats::TrackingStats(int64_t window_ns)
+    : window_ns(window_ns) {
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        std::memset(&devices[i].current, 0, sizeof(TrackingQuality));
+        devices[i].current.index = i;
+    }
+}
+
+void TrackingStats::sample(vr::TrackedDeviceIndex_t i, vr::ETrackedDeviceClass device_class, const vr::TrackedDevicePose_t& pose, int64_t time_ns) {
+    if (window_start_ns < 0) {
+        window_start_ns = time_ns;
+    }
+    Device& device = devices[i];
+    TrackingQuality& q = device.current;
+    int state = trackingState(pose);
+
+    // The time since the previous sample is spent in the previous state
+    if (device.state >= 0) {
+        q.durations[device.state] += (time_ns - device.last_time_ns) * 1e-9f;
+    }
+    device.state = state;
+    device.last_time_ns = time_ns;
+
+    q.device_class = static_cast<uint8_t>(device_class);
+    q.samples++;
+    q.counts[state]++;
+
+    if (state == StateRunningOK) {
+        if (device.gap_start_ns >= 0) {
+            q.longest_gap = std::max(q.longest_gap, (time_ns - device.gap_start_ns) * 1e-9f);
+            device.gap_start_ns = -1;
+        }
+    } else if (device.gap_start_ns < 0) {
+        device.gap_start_ns = time_ns;
+    }
+}
+
+bool TrackingStats::endWindow(int64_t time_ns) {
+    if (window_start_ns < 0 || time_ns - window_start_ns < window_ns) {
+        return false;
+    }
+    window_seconds = (time_ns - window_start_ns) * 1e-9;
+    window_start_ns = time_ns;
+
+    result_count = 0;
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        Device& device = devices[i];
+        TrackingQuality& q = device.current;
+        if (q.samples > 0) {
+            // A gap still open counts up to now and continues in the next window
+            if (device.gap_start_ns >= 0) {
+                q.longest_gap = std::max(q.longest_gap, (time_ns - device.gap_start_ns) * 1e-9f);
+            }
+            q.valid_rate = static_cast<float>(q.counts[StateRunningOK] / window_seconds);
+            q.valid_fraction = static_cast<float>(q.counts[StateRunningOK]) / q.samples;
+            results_[result_count++] = q;
+        } else {
+            // Not sampled in the whole window: disconnected, start over when it returns
+            device.state = -1;
+            device.gap_start_ns = -1;
+        }
+        std::memset(&q, 0, sizeof(q));
+        q.index = i;
+        if (device.gap_start_ns >= 0) {
+            device.gap_start_ns = time_ns;
+        }
+    }
+    return true;
+}
+
+void TrackingStats::log() const {
+    for (uint32_t k = 0; k < result_count; k++) {
+        const TrackingQuality& q = results_[k];
+        VIVE_LOG(Info, "[TRACKING] device %u: %.1f valid poses/s (%.1f%%), longest gap %.3f s, "
+                 "out of range %.2f s, calibrating %.2f s, rotation only %.2f s, invalid %.2f s",
+                 q.index, q.valid_rate, q.valid_fraction * 100.0f, q.longest_gap,
+                 q.durations[StateRunningOutOfRange] + q.durations[StateCalibratingOutOfRange],
+                 q.durations[StateCalibrating], q.durations[StateRotationOnly],
+                 q.durations[StateInvalidPose] + q.durations[StateUninitialized]);
+    }
+}
@@ -115,12 +115,13 @@ class ViveControl(Node):
         if self.trigger_button_pressed:
             self.get_logger().info('Control active')
             # Extract relative pose data from VRControllerData message
-            delta_x = -msg.rel_pose.transform.translation.z
-            delta_y = -msg.rel_pose.transform.translation.x
-            delta_z = msg.rel_pose.transform.translation.y
-            qx = -msg.rel_pose.transform.rotation.z
-            qy = -msg.rel_pose.transform.rotation.x
-            qz = msg.rel_pose.transform.rotation.y
+            # vive_node publishes in ROS axes (REP-103), no remapping needed
+            delta_x = msg.rel_pose.transform.translation.x
+            delta_y = msg.rel_pose.transform.translation.y
+            delta_z = msg.rel_pose.transform.translation.z
+            qx = msg.rel_pose.transform.rotation.x
+            qy = msg.rel_pose.transform.rotation.y
+            qz = msg.rel_pose.transform.rotation.z
             qw = msg.rel_pose.transform.rotation.w
             euler = tf_transformations.euler_from_quaternion([qx, qy, qz, qw])
             delta_roll, delta_pitch, delta_yaw = euler
@@ -1,46 +1,167 @@
 #include <string>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <algorithm>
 #include <openvr.h>
 #include <chrono> // Include this for std::chrono
 #include <thread>
+#include <vector>
 
 #include "VRUtils.hpp"
 #include "json.hpp" // Include nlohmann/json
 #include "server.hpp"
+#include "realtime.hpp"
+#include "async_logger.hpp"
+#include "pose_source.hpp"
+#include "synthetic_pose_source.hpp"
+#include "replay_pose_source.hpp"
+#include "recorder.hpp"
+#include "calibration.hpp"
+#include "config_reloader.hpp"
+#include "property_poller.hpp"
+#include "tracking_stats.hpp"
+#include "pose_batch.hpp"
+#include "pose_filter.hpp"
+#include "dead_reckoning.hpp"
 
 
+// Publish a device in the frame of a reference device. Both are named by
+// serial number or device index; "*" as the device stands for every other
+// tracker and controller.
+struct RelativeRule {
+    std::string device;
+    std::string reference;
+};
+
 class ViveInput {
 public:
-    ViveInput(std::mutex &mutex, std::condition_variable &cv, VRControllerData &data);
+    ViveInput(std::unique_ptr<PoseSource> source, std::mutex &mutex, std::condition_variable &cv, TrackerSampleSlots &samples);
     ~ViveInput();
+    void setRealtimeConfig(const RealtimeConfig &config) { rt_config = config; }
+    void setRate(double hz) { period = std::chrono::microseconds(static_cast<int64_t>(1e6 / hz)); }
+    void setRecorder(Recorder *r) { recorder = r; }
+    void setCalibration(Calibration *c) { calibration = c; }
+    // One-Euro smoothing of the published poses, the raw poses are sent along
+    void setPoseFilter(PoseFilterConfig *config) { filter_config = config; }
+    // Source of reloaded calibration and filter configurations (SIGHUP)
+    void setConfigReloader(ConfigReloader *r) { reloader = r; }
+    // Extrapolate through tracking dropouts of up to this long, 0 to stop publishing instead
+    void setDeadReckoning(std::chrono::milliseconds window) { dead_reckoning_ns = window.count() * 1000000; }
+    // Relative poses are computed from the poses of one poll and sent through the server
+    void setRelativePoses(const std::vector<RelativeRule> &rules) { relative_rules = rules; relative_dirty = true; }
+    // Base stations are published through the server when they move more than this
+    void setServer(Server *s) { server = s; }
+    void setReferenceThreshold(double meters, double radians) { reference_threshold_m = meters; reference_threshold_rad = radians; }
+    // Serial numbers are taken from the property poller's table, never queried on the VR thread
+    void setDeviceMetadata(const DeviceMetadataTable *table) { device_metadata = table; }
+    PoseSource &poseSource() { return *source; }
     void runVR();
 
 private:
-    vr::IVRSystem *pHMD = nullptr;
-    vr::EVRInitError eError = vr::VRInitError_None;
+    std::unique_ptr<PoseSource> source;
+    std::chrono::microseconds period{5000}; // ~200Hz
+    Recorder *recorder = nullptr;
+    Calibration *calibration = nullptr;
+    // Resolved when a device connects and after a reload
+    CalibrationTransform device_calibration[vr::k_unMaxTrackedDeviceCount];
+    bool calibration_resolved[vr::k_unMaxTrackedDeviceCount] = {};
+    PoseFilterConfig *filter_config = nullptr;
+    ConfigReloader *reloader = nullptr;
+    PoseFilter pose_filter[vr::k_unMaxTrackedDeviceCount];
+    int64_t dead_reckoning_ns = 0;
+    DeadReckoning dead_reckoning[vr::k_unMaxTrackedDeviceCount];
+
+    // Relative poses, the reference of each device resolved when devices come and go
+    std::vector<RelativeRule> relative_rules;
+    bool relative_dirty = true;
+    int relative_reference[vr::k_unMaxTrackedDeviceCount];
+    int batch_slot[vr::k_unMaxTrackedDeviceCount];
+    RelativePoseData relative_poses[vr::k_unMaxTrackedDeviceCount];
+    bool deviceMatches(const std::string &name, vr::TrackedDeviceIndex_t i) const;
+    void resolveRelativePoses();
+    void publishRelativePoses(int64_t time_ns);
+
+    // Base station monitoring, checked at a low rate
+    Server *server = nullptr;
+    double reference_threshold_m = 0.005;
+    double reference_threshold_rad = 0.5 * M_PI / 180.0;
+    const std::chrono::seconds reference_check_period{1};
+    bool reference_published[vr::k_unMaxTrackedDeviceCount] = {};
+
+    // Serial number per device index, copied from the metadata table when it changes
+    const DeviceMetadataTable *device_metadata = nullptr;
+    char device_serial[vr::k_unMaxTrackedDeviceCount][sizeof(DeviceMetadata::serial)] = {};
+    uint64_t serial_version[vr::k_unMaxTrackedDeviceCount] = {};
+    bool serial_known[vr::k_unMaxTrackedDeviceCount] = {};
+    bool refreshSerial(vr::TrackedDeviceIndex_t i);
+    vr::HmdMatrix34_t reference_pose[vr::k_unMaxTrackedDeviceCount];
+    uint32_t frame = 0;
     vr::TrackedDevicePose_t trackedDevicePose[vr::k_unMaxTrackedDeviceCount];
+    // Trackers to publish this iteration
+    PoseBatch batch;
 
     std::mutex &data_mutex;
     std::condition_variable &data_cv;
-    VRControllerData &shared_data;
+    TrackerSampleSlots &shared_samples;
     VRControllerData local_data;
+    RealtimeConfig rt_config;
+
+    // Tracking result counters per device, reported every 10 s
+    TrackingStats tracking_stats;
+
+    // Class and role per device index, refreshed on device events
+    vr::ETrackedDeviceClass device_class[vr::k_unMaxTrackedDeviceCount];
+    vr::ETrackedControllerRole device_role[vr::k_unMaxTrackedDeviceCount];
+    bool device_known[vr::k_unMaxTrackedDeviceCount] = {};
+
+    // Input state per device index, buttons as VRButtonFlag bits
+    vr::VRControllerState_t input_state[vr::k_unMaxTrackedDeviceCount];
+    uint8_t prev_buttons[vr::k_unMaxTrackedDeviceCount] = {};
+    uint8_t pending_pressed[vr::k_unMaxTrackedDeviceCount] = {};
+    uint8_t pending_released[vr::k_unMaxTrackedDeviceCount] = {};
 
     bool initVR();
     bool shutdownVR();
+    void pollInputEvents();
+    bool captureInput(vr::TrackedDeviceIndex_t i);
+    void checkTrackingReference(vr::TrackedDeviceIndex_t i);
+    void publishTrackingReference(vr::TrackedDeviceIndex_t i, bool valid);
 
-    // Variables to store previous position and time
-    vr::HmdVector3_t prev_position;
-    std::chrono::steady_clock::time_point prev_time;
-    bool first_run = true;
+    // Pose source recovery, e.g. after a vrserver restart
+    bool source_available = false;
+    std::chrono::steady_clock::duration retry_delay;
+    std::chrono::steady_clock::time_point next_retry;
+    const std::chrono::milliseconds min_retry_delay{500};
+    const std::chrono::seconds max_retry_delay{30};
+    bool reconnectSource();
+    void handleSourceLost();
+    void resetDeviceState();
+    void publishStatus();
+
+    // Variables to store previous position and time, per device index
+    vr::HmdVector3_t prev_position[vr::k_unMaxTrackedDeviceCount];
+    std::chrono::steady_clock::time_point prev_time[vr::k_unMaxTrackedDeviceCount];
+    bool first_run[vr::k_unMaxTrackedDeviceCount];
     // const float velocity_threshold = 2.5f;
     const float distance_threshold = 0.1f;
 
 };
 
-ViveInput::ViveInput(std::mutex &mutex, std::condition_variable &cv, VRControllerData &data) 
-    : data_mutex(mutex), data_cv(cv), shared_data(data) {
-    if (!initVR()) {
+ViveInput::ViveInput(std::unique_ptr<PoseSource> source, std::mutex &mutex, std::condition_variable &cv, TrackerSampleSlots &samples)
+    : source(std::move(source)), data_mutex(mutex), data_cv(cv), shared_samples(samples) {
+    std::fill(std::begin(first_run), std::end(first_run), true);
+    retry_delay = min_retry_delay;
+    VIVE_LOG(Info, "Using %s pose source", this->source->name());
+    source_available = initVR();
+    if (!source_available) {
         shutdownVR();
-        throw std::runtime_error("Failed to initialize VR");
+        if (!this->source->recoverable()) {
+            throw std::runtime_error("Failed to initialize VR");
+        }
+        next_retry = std::chrono::steady_clock::now() + retry_delay;
+        VIVE_LOG(Warning, "%s is unavailable, retrying in the background", this->source->name());
     }
 }
 ViveInput::~ViveInput() {
@@ -48,141 +169,775 @@ ViveInput::~ViveInput() {
 }
 
 void ViveInput::runVR() {
-  logMessage(Info, "Starting VR loop");
-  auto lastLogTime = std::chrono::steady_clock::now(); // Initialize the last log time
+  VIVE_LOG(Info, "Starting VR loop");
+  RealtimeUtils::configureThread(rt_config, "VR");
+  LoopStats stats("VR", period, std::chrono::seconds(10));
+  stats.setCheckAllocations(rt_config.check_allocations);
+  auto nextWakeTime = std::chrono::steady_clock::now();
+  auto nextReferenceCheck = nextWakeTime;
+  // Idle while no tracker has a valid pose; the "no tracker" message backs off exponentially
+  bool idle = false;
+  auto idleSince = nextWakeTime;
+  auto nextIdleLog = nextWakeTime;
+  std::chrono::seconds idleLogInterval(1);
+  const bool paced = source->pacesItself();
+  publishStatus();
 
-  while (true) {
+  while (!Server::stopRequested().load() && !source->finished()) {
     bool trackerDetected = false;
-    VRUtils::resetJsonData(local_data);
+
+    if (!source_available && !reconnectSource()) {
+      stats.pause();
+      std::this_thread::sleep_for(std::chrono::milliseconds(100)); // stay responsive to stop requests
+      nextWakeTime = std::chrono::steady_clock::now();
+      continue;
+    }
 
     // update the poses
-    pHMD->GetDeviceToAbsoluteTrackingPose(vr::TrackingUniverseStanding, 0, trackedDevicePose, vr::k_unMaxTrackedDeviceCount);
+    source->getPoses(trackedDevicePose, vr::k_unMaxTrackedDeviceCount);
+    int64_t sampleTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t wallTimeNs = VRUtils::wallTimeNs();
+    frame++;
+
+    pollInputEvents();
+    if (!source->healthy()) {
+      handleSourceLost();
+      continue;
+    }
+
+    // Files are parsed on the reloader thread; here the result is only swapped in.
+    // New filter parameters apply to the running filter state.
+    if (reloader && reloader->apply(calibration, filter_config).calibration) {
+      std::fill(std::begin(calibration_resolved), std::end(calibration_resolved), false);
+      // Base stations move with the world frame, republish them without raising the alarm
+      std::fill(std::begin(reference_published), std::end(reference_published), false);
+      // The last poses are in the old frame, no jump check against them
+      std::fill(std::begin(first_run), std::end(first_run), true);
+    }
+
+    bool checkReferences = server && std::chrono::steady_clock::now() >= nextReferenceCheck;
+    if (checkReferences) {
+      nextReferenceCheck += reference_check_period;
+    }
 
+    // First pass: input, recording, statistics and calibration per device
+    batch.clear();
     for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
-      if (trackedDevicePose[i].bDeviceIsConnected && trackedDevicePose[i].bPoseIsValid
-          && trackedDevicePose[i].eTrackingResult == vr::TrackingResult_Running_OK) {
-
-      if (pHMD->GetTrackedDeviceClass(i) == vr::TrackedDeviceClass_GenericTracker) {
-          trackerDetected = true;
-
-          // Get the pose of the device
-          vr::HmdMatrix34_t steamVRMatrix = trackedDevicePose[i].mDeviceToAbsoluteTracking;
-          vr::HmdVector3_t position = VRTransformUtils::GetPosition(steamVRMatrix);
-          vr::HmdQuaternion_t quaternion = VRTransformUtils::GetQuaternion(steamVRMatrix);
-          EulerAngle euler = VRTransformUtils::QuaternionToEulerXYZ(quaternion);
-          logMessage(Debug, "[POSE CM]: " + std::to_string(position.v[0] * 100) + " " + std::to_string(position.v[1] * 100) + " " + std::to_string(position.v[2] * 100));
-          logMessage(Debug, "[EULER DEG]: " + std::to_string(euler.x * (180.0 / M_PI)) + " " + std::to_string(euler.y * (180.0 / M_PI)) + " " + std::to_string(euler.z * (180.0 / M_PI)));
-
-          local_data.time = Server::getCurrentTimeWithMilliseconds();
-          local_data.role = VRUtils::controllerRoleCheck(pHMD, i);
-          local_data.pose_x = position.v[0];
-          local_data.pose_y = position.v[1];
-          local_data.pose_z = position.v[2];
-          local_data.pose_qx = quaternion.x;
-          local_data.pose_qy = quaternion.y;
-          local_data.pose_qz = quaternion.z;
-          local_data.pose_qw = quaternion.w;
-
-          // TODO Use the data from the pogo pin connector
-
-          // Check if the input data is reasonable
-          auto current_time = std::chrono::steady_clock::now();
-          if (!first_run) {
-              std::chrono::duration<float> time_diff = current_time - prev_time;
-              float delta_time = time_diff.count();
-              float delta_x = position.v[0] - prev_position.v[0];
-              float delta_y = position.v[1] - prev_position.v[1];
-              float delta_z = position.v[2] - prev_position.v[2];
-              float delta_distance = std::sqrt(delta_x * delta_x + delta_y * delta_y + delta_z * delta_z);
-              float velocity = delta_distance / delta_time;
-
-              logMessage(Debug, "Velocity: " + std::to_string(velocity) + " units/s");
-              logMessage(Debug, "Delta pos: " + std::to_string(delta_distance) + " units");
-              logMessage(Debug, "prev pos: " + std::to_string(prev_position.v[0]) + " " + std::to_string(prev_position.v[1]) + " " + std::to_string(prev_position.v[2]));
-              logMessage(Debug, "cur t: " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(current_time.time_since_epoch()).count()));
-              logMessage(Debug, "prev t: " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(prev_time.time_since_epoch()).count()));
-
-              // check if delta distance is too high
-              if (delta_distance > 0.05) {
-                  logMessage(Warning, "Unreasonable delta_distance detected: " + std::to_string(delta_distance) + " units. Skipping this data." + "\n");
-                  continue; // Skip this iteration if delta_distance is too high
-              } else {
-                  logMessage(Debug, "Will publish this data");
-              }
-          } else {
-              first_run = false; // Set the flag to false after the first run
+      if (!trackedDevicePose[i].bDeviceIsConnected) {
+        relative_dirty |= device_known[i];
+        device_known[i] = false;
+        first_run[i] = true;
+        calibration_resolved[i] = false;
+        pose_filter[i].reset();
+        dead_reckoning[i].reset();
+        if (checkReferences && reference_published[i]) {
+          publishTrackingReference(i, false);
+        }
+        // Another device may get this index, read its serial number again
+        serial_known[i] = false;
+        serial_version[i] = 0;
+        continue;
+      }
+      if (!device_known[i]) {
+        device_class[i] = source->getDeviceClass(i);
+        device_role[i] = source->getControllerRole(i);
+        device_known[i] = true;
+        relative_dirty = true;
+      }
+      bool serialKnown = refreshSerial(i);
+      vr::ETrackedDeviceClass deviceClass = device_class[i];
+      bool inputDevice = deviceClass == vr::TrackedDeviceClass_GenericTracker || deviceClass == vr::TrackedDeviceClass_Controller;
+      // Base stations are published under their serial number
+      bool reference = checkReferences && deviceClass == vr::TrackedDeviceClass_TrackingReference && serialKnown;
+
+      // Sample the input state together with the pose of the same instant
+      bool hasInput = inputDevice && captureInput(i);
+      vr::ETrackedControllerRole role = inputDevice ? device_role[i] : vr::TrackedControllerRole_Invalid;
+      if (recorder) {
+        recorder->record(sampleTimeNs, frame, i, deviceClass, role, trackedDevicePose[i], hasInput ? &input_state[i] : nullptr);
+      }
+      if (inputDevice) {
+        tracking_stats.sample(i, deviceClass, trackedDevicePose[i], sampleTimeNs);
+      }
+      // Recorded raw, published in the calibrated world frame
+      if (calibration && (inputDevice || reference)) {
+        if (!calibration_resolved[i]) {
+          if (!serialKnown) {
+            continue; // Not published until the calibration by serial number can be resolved
           }
+          device_calibration[i] = calibration->resolve(i, device_serial[i], inputDevice);
+          calibration_resolved[i] = true;
+        }
+        if (trackedDevicePose[i].bPoseIsValid) {
+          device_calibration[i].apply(trackedDevicePose[i]);
+        }
+      }
+      if (reference) {
+        checkTrackingReference(i);
+      }
 
-          // Update previous record
-          prev_position = position;
-          prev_time = current_time;
+      if (inputDevice) {
+        bool tracked = trackedDevicePose[i].bPoseIsValid && trackedDevicePose[i].eTrackingResult == vr::TrackingResult_Running_OK;
+        uint8_t entryFlags = hasInput ? BatchHasInput : 0;
+        if (dead_reckoning_ns > 0) {
+          DeadReckoning::Result result = dead_reckoning[i].update(sampleTimeNs, dead_reckoning_ns, trackedDevicePose[i]);
+          tracked = result != DeadReckoning::Lost;
+          entryFlags |= result == DeadReckoning::Predicted ? BatchPredicted : 0;
+        }
+        if (!tracked) {
+          first_run[i] = true; // No jump check against the pose from before the gap
+          continue;
+        }
+        trackerDetected = true;
+        batch.add(i, trackedDevicePose[i], entryFlags);
+      }
+    }
+
+    // Check if the input data is reasonable, before any pose is derived from it
+    auto current_time = std::chrono::steady_clock::now();
+    for (uint32_t k = 0; k < batch.count; k++) {
+      uint32_t i = batch.device[k];
+      vr::HmdVector3_t position;
+      position.v[0] = batch.position[0][k];
+      position.v[1] = batch.position[1][k];
+      position.v[2] = batch.position[2][k];
+      if (!first_run[i]) {
+          std::chrono::duration<float> time_diff = current_time - prev_time[i];
+          float delta_time = time_diff.count();
+          float delta_x = position.v[0] - prev_position[i].v[0];
+          float delta_y = position.v[1] - prev_position[i].v[1];
+          float delta_z = position.v[2] - prev_position[i].v[2];
+          float delta_distance = std::sqrt(delta_x * delta_x + delta_y * delta_y + delta_z * delta_z);
+          float velocity = delta_distance / delta_time;
 
-          // Update shared data
-          {
-            std::lock_guard<std::mutex> lock(data_mutex);
-            shared_data = local_data;
-            shared_data.time = Server::getCurrentTimeWithMilliseconds();
+          VIVE_LOG(Debug, "Velocity: %f units/s", velocity);
+          VIVE_LOG(Debug, "Delta pos: %f units", delta_distance);
+          VIVE_LOG(Debug, "prev pos: %f %f %f", prev_position[i].v[0], prev_position[i].v[1], prev_position[i].v[2]);
+          VIVE_LOG(Debug, "cur t: %lld", (long long)std::chrono::duration_cast<std::chrono::milliseconds>(current_time.time_since_epoch()).count());
+          VIVE_LOG(Debug, "prev t: %lld", (long long)std::chrono::duration_cast<std::chrono::milliseconds>(prev_time[i].time_since_epoch()).count());
+
+          // check if delta distance is too high
+          if (delta_distance > 0.05) {
+              VIVE_LOG(Warning, "Unreasonable delta_distance detected: %f units. Skipping this data.", delta_distance);
+              batch.flags[k] |= BatchRejected; // Skip this sample if delta_distance is too high
+              continue;
+          } else {
+              VIVE_LOG(Debug, "Will publish this data");
           }
-          data_cv.notify_one(); // Notify the server thread
+      } else {
+          first_run[i] = false; // Set the flag to false after the first run
+      }
+
+      // Update previous record
+      prev_position[i] = position;
+      prev_time[i] = current_time;
+    }
+    publishRelativePoses(wallTimeNs);
+
+    // Second pass over the batch: hand-over to the server
+    for (uint32_t k = 0; k < batch.count; k++) {
+      if (batch.flags[k] & BatchRejected) {
+        continue;
+      }
+      uint32_t i = batch.device[k];
+      VRUtils::resetJsonData(local_data);
+      if (batch.flags[k] & BatchHasInput) {
+          VRUtils::applyControllerState(input_state[i], local_data);
+      }
+
+      // Get the pose of the device
+      vr::HmdVector3_t position;
+      position.v[0] = batch.position[0][k];
+      position.v[1] = batch.position[1][k];
+      position.v[2] = batch.position[2][k];
+      transform::Quaternion<double> quaternion = batch.quaternion(k);
+      // The Euler angles are only computed when the Debug level is enabled
+      VIVE_LOG(Debug, "[POSE CM]: %f %f %f", position.v[0] * 100, position.v[1] * 100, position.v[2] * 100);
+      VIVE_LOG(Debug, "[EULER DEG]: %f %f %f", batch.euler(k).x * (180.0 / M_PI), batch.euler(k).y * (180.0 / M_PI),
+               batch.euler(k).z * (180.0 / M_PI));
+
+      local_data.time_ns = wallTimeNs;
+      local_data.flags = (batch.flags[k] & BatchPredicted) ? TrackerPredicted : 0;
+      local_data.device = i;
+      local_data.role = device_role[i];
+      local_data.pose_x = batch.position[0][k];
+      local_data.pose_y = batch.position[1][k];
+      local_data.pose_z = batch.position[2][k];
+      local_data.pose_qx = quaternion.x;
+      local_data.pose_qy = quaternion.y;
+      local_data.pose_qz = quaternion.z;
+      local_data.pose_qw = quaternion.w;
+      local_data.vel_x = batch.velocity[0][k];
+      local_data.vel_y = batch.velocity[1][k];
+      local_data.vel_z = batch.velocity[2][k];
+      local_data.ang_vel_x = batch.angular_velocity[0][k];
+      local_data.ang_vel_y = batch.angular_velocity[1][k];
+      local_data.ang_vel_z = batch.angular_velocity[2][k];
+
+      local_data.raw_x = local_data.pose_x;
+      local_data.raw_y = local_data.pose_y;
+      local_data.raw_z = local_data.pose_z;
+      local_data.raw_qx = local_data.pose_qx;
+      local_data.raw_qy = local_data.pose_qy;
+      local_data.raw_qz = local_data.pose_qz;
+      local_data.raw_qw = local_data.pose_qw;
+      if (filter_config) {
+          transform::Vector3<double> p{local_data.pose_x, local_data.pose_y, local_data.pose_z};
+          transform::Quaternion<double> q = quaternion;
+          pose_filter[i].filter(*filter_config, sampleTimeNs, p, q);
+          local_data.pose_x = p.x;
+          local_data.pose_y = p.y;
+          local_data.pose_z = p.z;
+          local_data.pose_qx = q.x;
+          local_data.pose_qy = q.y;
+          local_data.pose_qz = q.z;
+          local_data.pose_qw = q.w;
+      }
+
+      // Hand over the edges collected since the last published sample of this device
+      local_data.pressed_edges = pending_pressed[i];
+      local_data.released_edges = pending_released[i];
+      pending_pressed[i] = 0;
+      pending_released[i] = 0;
+
+      // Update this device's slot, keeping edges the server has not sent yet
+      {
+        std::lock_guard<std::mutex> lock(data_mutex);
+        VRControllerData &slot = shared_samples.latest[i];
+        uint64_t bit = uint64_t(1) << i;
+        if (shared_samples.pending & bit) {
+          local_data.pressed_edges |= slot.pressed_edges;
+          local_data.released_edges |= slot.released_edges;
         }
+        local_data.sequence = slot.sequence + 1;
+        slot = local_data;
+        shared_samples.pending |= bit;
+      }
+      data_cv.notify_one(); // Notify the server thread
+    }
+
+    if (tracking_stats.endWindow(sampleTimeNs)) {
+      tracking_stats.log();
+      if (server) {
+        server->publishTrackingQuality(tracking_stats.results(), tracking_stats.resultCount(), tracking_stats.windowSeconds());
       }
     }
 
     auto currentTime = std::chrono::steady_clock::now();
     if (!trackerDetected) {
-      if (std::chrono::duration_cast<std::chrono::seconds>(currentTime - lastLogTime).count() >= 1) {
-        logMessage(Info, "no tracker detected, currentTime: " + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(currentTime.time_since_epoch()).count()));
-        first_run = true; // Reset the first run flag
-        lastLogTime = currentTime; // Update the last log time
+      stats.pause();
+      if (!idle) {
+        idle = true;
+        idleSince = currentTime;
+        idleLogInterval = std::chrono::seconds(1);
+        nextIdleLog = currentTime + idleLogInterval;
+      } else if (currentTime >= nextIdleLog) {
+        VIVE_LOG(Info, "no tracker detected for %.0f s", std::chrono::duration<double>(currentTime - idleSince).count());
+        idleLogInterval = std::min(idleLogInterval * 2, std::chrono::seconds(60));
+        nextIdleLog = currentTime + idleLogInterval;
       }
-      std::this_thread::sleep_for(std::chrono::milliseconds(50)); // ~20Hz
     } else {
-      std::this_thread::sleep_for(std::chrono::milliseconds(5)); // ~200Hz
-      lastLogTime = currentTime;
+      if (idle && currentTime - idleSince >= std::chrono::seconds(1)) {
+        VIVE_LOG(Info, "Tracker detected after %.1f s", std::chrono::duration<double>(currentTime - idleSince).count());
+      }
+      idle = false;
+      stats.tick();
+    }
+
+    // Idle iterations only read the shared pose array and the event queue, so
+    // keeping the poll period while idle costs next to nothing and streaming
+    // starts within one period of a tracker becoming valid
+    if (!paced) {
+      // Fixed rate without drift; after an overrun restart from now
+      nextWakeTime += period;
+      if (nextWakeTime < currentTime) {
+        nextWakeTime = currentTime;
+      }
+      std::this_thread::sleep_until(nextWakeTime);
     }
   }
 }
 
-bool ViveInput::initVR() {
-    // Initialize VR runtime
-    eError = vr::VRInitError_None;
-    pHMD = vr::VR_Init(&eError, vr::VRApplication_Background);
-    if (eError != vr::VRInitError_None) {
-        pHMD = NULL;
-        std::string error_msg = vr::VR_GetVRInitErrorAsEnglishDescription(eError);
-        logMessage(Error, "Unable to init VR runtime: " + error_msg);
+// Retry with exponential backoff, true once the source is back
+bool ViveInput::reconnectSource() {
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_retry) {
         return false;
-    } else {
-        logMessage(Info, "VR runtime initialized");
     }
+    if (!initVR()) {
+        shutdownVR();
+        retry_delay = std::min<std::chrono::steady_clock::duration>(retry_delay * 2, max_retry_delay);
+        next_retry = now + retry_delay;
+        VIVE_LOG(Warning, "%s still unavailable, retrying in %.1f s", source->name(),
+                 std::chrono::duration<double>(retry_delay).count());
+        return false;
+    }
+    VIVE_LOG(Info, "%s is available again", source->name());
+    source_available = true;
+    retry_delay = min_retry_delay;
+    publishStatus();
     return true;
 }
-bool ViveInput::shutdownVR() {
-    // Shutdown VR runtime
-    if (pHMD) {
-        logMessage(Info, "Shutting down VR runtime");
-        vr::VR_Shutdown();
+
+void ViveInput::handleSourceLost() {
+    VIVE_LOG(Warning, "%s lost, reconnecting", source->name());
+    // Before the runtime goes away, the messages use only cached state
+    resetDeviceState();
+    shutdownVR();
+    source_available = false;
+    retry_delay = min_retry_delay;
+    next_retry = std::chrono::steady_clock::now() + retry_delay;
+    publishStatus();
+}
+
+// Device indices may be reassigned by the new runtime session
+void ViveInput::resetDeviceState() {
+    std::fill(std::begin(first_run), std::end(first_run), true);
+    std::fill(std::begin(device_known), std::end(device_known), false);
+    std::fill(std::begin(calibration_resolved), std::end(calibration_resolved), false);
+    std::fill(std::begin(prev_buttons), std::end(prev_buttons), 0);
+    std::fill(std::begin(pending_pressed), std::end(pending_pressed), 0);
+    std::fill(std::begin(pending_released), std::end(pending_released), 0);
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        pose_filter[i].reset();
+        dead_reckoning[i].reset();
+        if (reference_published[i]) {
+            publishTrackingReference(i, false);
+        }
+    }
+    std::fill(std::begin(serial_known), std::end(serial_known), false);
+    std::fill(std::begin(serial_version), std::end(serial_version), 0);
+}
+
+bool ViveInput::deviceMatches(const std::string &name, vr::TrackedDeviceIndex_t i) const {
+    if (serial_known[i] && name == device_serial[i]) {
+        return true;
+    }
+    // A device index, compared as a number so nothing is formatted on the VR thread
+    if (name.empty() || !std::isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    char *end = nullptr;
+    unsigned long index = std::strtoul(name.c_str(), &end, 10);
+    return *end == '\0' && index == i;
+}
+
+// The serial number of a device once the property poller has stored it, false
+// while it is unknown. Sources without metadata name devices by index only.
+// A different serial number on the same index resolves the calibration and
+// the relative poses again.
+bool ViveInput::refreshSerial(vr::TrackedDeviceIndex_t i) {
+    if (!device_metadata || !source->providesMetadata()) {
+        return true;
+    }
+    if (device_metadata->version(i) == serial_version[i]) {
+        return serial_known[i];
     }
+    DeviceMetadata metadata;
+    serial_version[i] = device_metadata->load(i, metadata);
+    if (!metadata.connected) {
+        return serial_known[i]; // The poller has not seen the device yet
+    }
+    metadata.serial[sizeof(metadata.serial) - 1] = '\0';
+    if (!serial_known[i] || std::strcmp(metadata.serial, device_serial[i]) != 0) {
+        std::memcpy(device_serial[i], metadata.serial, sizeof(metadata.serial));
+        calibration_resolved[i] = false;
+        relative_dirty = true;
+    }
+    serial_known[i] = true;
+    return true;
+}
+
+// The first rule that names a device and whose reference is connected wins
+void ViveInput::resolveRelativePoses() {
+    relative_dirty = false;
+    std::fill(std::begin(relative_reference), std::end(relative_reference), -1);
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        if (!device_known[i] ||
+            (device_class[i] != vr::TrackedDeviceClass_GenericTracker && device_class[i] != vr::TrackedDeviceClass_Controller)) {
+            continue;
+        }
+        for (const RelativeRule &rule : relative_rules) {
+            if (rule.device != "*" && !deviceMatches(rule.device, i)) {
+                continue;
+            }
+            for (uint32_t r = 0; r < vr::k_unMaxTrackedDeviceCount && relative_reference[i] < 0; r++) {
+                if (r != i && device_known[r] && deviceMatches(rule.reference, r)) {
+                    relative_reference[i] = static_cast<int>(r);
+                }
+            }
+            if (relative_reference[i] >= 0) {
+                VIVE_LOG(Info, "Publishing device %u relative to device %d", i, relative_reference[i]);
+                break;
+            }
+        }
+    }
+}
+
+// Device and reference from the same batch, so both poses share the sample instant
+void ViveInput::publishRelativePoses(int64_t time_ns) {
+    if (relative_rules.empty() || !server) {
+        return;
+    }
+    if (relative_dirty) {
+        resolveRelativePoses();
+    }
+    std::fill(std::begin(batch_slot), std::end(batch_slot), -1);
+    for (uint32_t k = 0; k < batch.count; k++) {
+        if (!(batch.flags[k] & BatchRejected)) {
+            batch_slot[batch.device[k]] = static_cast<int>(k);
+        }
+    }
+
+    uint32_t count = 0;
+    for (uint32_t k = 0; k < batch.count; k++) {
+        uint32_t i = batch.device[k];
+        int reference = relative_reference[i];
+        if (reference < 0 || batch_slot[i] < 0 || batch_slot[reference] < 0) {
+            continue;
+        }
+        uint32_t kr = static_cast<uint32_t>(batch_slot[reference]);
+        transform::Quaternion<double> reference_inverse = batch.quaternion(kr).conjugate();
+        transform::Vector3<double> offset{batch.position[0][k] - batch.position[0][kr], batch.position[1][k] - batch.position[1][kr],
+                                          batch.position[2][k] - batch.position[2][kr]};
+        transform::Vector3<double> t = reference_inverse.rotate(offset);
+        transform::Quaternion<double> q = reference_inverse * batch.quaternion(k);
+        q = q.w < 0.0 ? -q : q;
+
+        RelativePoseData &out = relative_poses[count++];
+        out.time_ns = time_ns;
+        out.device = i;
+        out.reference = static_cast<uint32_t>(reference);
+        out.pose_x = t.x;
+        out.pose_y = t.y;
+        out.pose_z = t.z;
+        out.pose_qx = q.x;
+        out.pose_qy = q.y;
+        out.pose_qz = q.z;
+        out.pose_qw = q.w;
+        out.flags = ((batch.flags[k] | batch.flags[kr]) & BatchPredicted) ? TrackerPredicted : 0;
+    }
+    server->publishRelativePoses(relative_poses, count);
+}
+
+void ViveInput::publishStatus() {
+    if (server) {
+        server->publishStatus(source->name(), source_available);
+    }
+}
+
+// Drain the event queue so presses shorter than a poll period still produce edges
+void ViveInput::pollInputEvents() {
+    vr::VREvent_t event;
+    while (source->pollNextEvent(&event)) {
+        if (event.eventType == vr::VREvent_TrackedDeviceRoleChanged) {
+            // Roles move between devices and the event may carry no device index
+            std::fill(std::begin(device_known), std::end(device_known), false);
+            continue;
+        }
+        if (event.trackedDeviceIndex >= vr::k_unMaxTrackedDeviceCount) {
+            continue;
+        }
+        uint32_t i = event.trackedDeviceIndex;
+        switch (event.eventType) {
+            case vr::VREvent_ButtonPress:
+                pending_pressed[i] |= VRUtils::buttonFlagFromId(event.data.controller.button, false);
+                break;
+            case vr::VREvent_ButtonUnpress:
+                pending_released[i] |= VRUtils::buttonFlagFromId(event.data.controller.button, false);
+                break;
+            case vr::VREvent_ButtonTouch:
+                pending_pressed[i] |= VRUtils::buttonFlagFromId(event.data.controller.button, true);
+                break;
+            case vr::VREvent_ButtonUntouch:
+                pending_released[i] |= VRUtils::buttonFlagFromId(event.data.controller.button, true);
+                break;
+            case vr::VREvent_TrackedDeviceActivated:
+            case vr::VREvent_TrackedDeviceDeactivated:
+            case vr::VREvent_TrackedDeviceUpdated:
+                device_known[i] = false;
+                first_run[i] = true;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// Read buttons and axes (pogo pins on trackers) and refresh the pose from the same sample
+bool ViveInput::captureInput(vr::TrackedDeviceIndex_t i) {
+    if (!source->getControllerStateWithPose(i, &input_state[i], &trackedDevicePose[i])) {
+        return false; // No input available, keep the batch pose
+    }
+
+    uint8_t buttons = VRUtils::buttonFlags(input_state[i]);
+    pending_pressed[i] |= buttons & ~prev_buttons[i];
+    pending_released[i] |= prev_buttons[i] & ~buttons;
+    prev_buttons[i] = buttons;
     return true;
 }
 
+// Publish a base station when first seen and whenever it moved, a moved base
+// station invalidates the calibration of the tracking universe
+void ViveInput::checkTrackingReference(vr::TrackedDeviceIndex_t i) {
+    const vr::TrackedDevicePose_t &pose = trackedDevicePose[i];
+    if (!pose.bPoseIsValid) {
+        if (reference_published[i]) {
+            publishTrackingReference(i, false);
+        }
+        return;
+    }
+    const vr::HmdMatrix34_t &current = pose.mDeviceToAbsoluteTracking;
+    if (!reference_published[i]) {
+        publishTrackingReference(i, true);
+        return;
+    }
+
+    transform::RigidTransform<float> last = VRTransformUtils::ToRigidTransform(reference_pose[i]);
+    transform::RigidTransform<float> now = VRTransformUtils::ToRigidTransform(current);
+    double distance = (now.translation - last.translation).norm();
+    // Rotation angle of last^-1 * now from its trace
+    double trace = (last.rotation.transpose() * now.rotation).trace();
+    double angle = std::acos(std::max(-1.0, std::min(1.0, (trace - 1.0) / 2.0)));
+    if (distance > reference_threshold_m || angle > reference_threshold_rad) {
+        VIVE_LOG(Warning, "Base station %u moved by %.1f mm and %.2f deg, the calibration may be stale",
+                 i, distance * 1000.0, angle * 180.0 / M_PI);
+        publishTrackingReference(i, true);
+    }
+}
+
+void ViveInput::publishTrackingReference(vr::TrackedDeviceIndex_t i, bool valid) {
+    TrackingReferenceData data;
+    data.index = i;
+    data.valid = valid;
+    data.serial = device_serial[i];
+    data.time_ns = VRUtils::wallTimeNs();
+    data.time = VRUtils::formatTime(data.time_ns);
+    data.pose_x = data.pose_y = data.pose_z = 0.0;
+    data.pose_qx = data.pose_qy = data.pose_qz = 0.0;
+    data.pose_qw = 1.0;
+    if (valid) {
+        const vr::HmdMatrix34_t &m = trackedDevicePose[i].mDeviceToAbsoluteTracking;
+        vr::HmdVector3_t position = VRTransformUtils::GetPosition(m);
+        vr::HmdQuaternion_t quaternion = VRTransformUtils::GetQuaternion(m);
+        data.pose_x = position.v[0];
+        data.pose_y = position.v[1];
+        data.pose_z = position.v[2];
+        data.pose_qx = quaternion.x;
+        data.pose_qy = quaternion.y;
+        data.pose_qz = quaternion.z;
+        data.pose_qw = quaternion.w;
+        reference_pose[i] = m;
+        if (!reference_published[i]) {
+            VIVE_LOG(Info, "Base station %u (%s) at %.3f %.3f %.3f", i, data.serial.c_str(), data.pose_x, data.pose_y, data.pose_z);
+        }
+    } else {
+        VIVE_LOG(Warning, "Base station %u (%s) lost", i, data.serial.c_str());
+    }
+    reference_published[i] = valid;
+    server->publishTrackingReference(data);
+}
+
+bool ViveInput::initVR() {
+    return source->init();
+}
+bool ViveInput::shutdownVR() {
+    source->shutdown();
+    return true;
+}
+
+static void printUsage(const char *prog) {
+    std::cout << "Usage: " << prog << " [options]\n"
+              << "  --rt-priority <1-99>  SCHED_FIFO priority for the VR and server threads\n"
+              << "  --vr-cpu <n>          pin the VR thread to CPU n\n"
+              << "  --server-cpu <n>      pin the server thread to CPU n\n"
+              << "  --mlock               lock process memory (mlockall)\n"
+              << "  --check-alloc         report heap allocations on the VR thread\n"
+              << "  --log-level <level>   debug, info, warning or error (default: $VIVE_LOG_LEVEL or info)\n"
+              << "  --rate <hz>           poll rate (default 200)\n"
+              << "  --synthetic <n>       generate n synthetic trackers instead of using SteamVR\n"
+              << "  --synthetic-references <n>  add n synthetic base stations\n"
+              << "  --trajectory <name>   synthetic trajectory: static, circle or figure8 (default circle)\n"
+              << "  --position-noise <m>  synthetic position noise standard deviation\n"
+              << "  --rotation-noise <r>  synthetic rotation noise standard deviation (rad)\n"
+              << "  --dropout-rate <n>    synthetic dropouts per second and device\n"
+              << "  --dropout-duration <s> synthetic dropout length (default 0.05)\n"
+              << "  --record <file>       record every raw sample to a binary file\n"
+              << "  --record-max-mb <n>   preallocated recording size (default 4096)\n"
+              << "  --replay <file>       play a recording back instead of using SteamVR\n"
+              << "  --replay-speed <x>    playback speed 0.1-100, 0 for as fast as possible (default 1)\n"
+              << "  --replay-seek <s>     start the playback s seconds into the recording\n"
+              << "  --replay-loop         restart the playback at the end\n"
+              << "  --calibration <file>  per-device world and tool calibration (JSON), reloaded on SIGHUP\n"
+              << "  --filter <file>       One-Euro smoothing parameters (JSON), reloaded on SIGHUP\n"
+              << "  --dead-reckoning <ms> extrapolate tracker poses through dropouts of up to ms (default 0, off)\n"
+              << "  --relative <device> <reference>  also publish device in the frame of reference (serial number\n"
+              << "                        or index, * for every other tracker); repeat for more pairs\n"
+              << "  --reference-threshold <mm> <deg>  base station movement that triggers an update (default 5 0.5)\n";
+}
+
 int main(int argc, char **argv) {
-    (void)argc;
-    (void)argv;
+    RealtimeConfig vr_rt, server_rt;
+    bool lock_memory = false;
+    double rate = 200.0;
+    bool synthetic = false;
+    SyntheticConfig synthetic_config;
+    std::string record_path;
+    size_t record_max_mb = 4096;
+    ReplayConfig replay_config;
+    std::string calibration_path;
+    std::string filter_path;
+    int dead_reckoning_ms = 0;
+    std::vector<RelativeRule> relative_rules;
+    double reference_threshold_mm = 5.0;
+    double reference_threshold_deg = 0.5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--rt-priority" && has_value) {
+            vr_rt.priority = server_rt.priority = std::atoi(argv[++i]);
+        } else if (arg == "--vr-cpu" && has_value) {
+            vr_rt.cpu = std::atoi(argv[++i]);
+        } else if (arg == "--server-cpu" && has_value) {
+            server_rt.cpu = std::atoi(argv[++i]);
+        } else if (arg == "--mlock") {
+            lock_memory = true;
+        } else if (arg == "--log-level" && has_value) {
+            setLogLevel(parseLogLevel(argv[++i], Info));
+        } else if (arg == "--rate" && has_value) {
+            rate = std::atof(argv[++i]);
+        } else if (arg == "--synthetic" && has_value) {
+            synthetic = true;
+            synthetic_config.devices = std::atoi(argv[++i]);
+        } else if (arg == "--synthetic-references" && has_value) {
+            synthetic_config.references = std::atoi(argv[++i]);
+        } else if (arg == "--trajectory" && has_value && SyntheticConfig::parseTrajectory(argv[i + 1], synthetic_config.trajectory)) {
+            i++;
+        } else if (arg == "--position-noise" && has_value) {
+            synthetic_config.position_noise = std::atof(argv[++i]);
+        } else if (arg == "--rotation-noise" && has_value) {
+            synthetic_config.rotation_noise = std::atof(argv[++i]);
+        } else if (arg == "--dropout-rate" && has_value) {
+            synthetic_config.dropout_rate = std::atof(argv[++i]);
+        } else if (arg == "--dropout-duration" && has_value) {
+            synthetic_config.dropout_duration = std::atof(argv[++i]);
+        } else if (arg == "--record" && has_value) {
+            record_path = argv[++i];
+        } else if (arg == "--record-max-mb" && has_value) {
+            record_max_mb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--replay" && has_value) {
+            replay_config.path = argv[++i];
+        } else if (arg == "--replay-speed" && has_value) {
+            replay_config.speed = std::atof(argv[++i]);
+        } else if (arg == "--replay-seek" && has_value) {
+            replay_config.seek = std::atof(argv[++i]);
+        } else if (arg == "--replay-loop") {
+            replay_config.loop = true;
+        } else if (arg == "--calibration" && has_value) {
+            calibration_path = argv[++i];
+        } else if (arg == "--filter" && has_value) {
+            filter_path = argv[++i];
+        } else if (arg == "--relative" && i + 2 < argc) {
+            relative_rules.push_back({argv[i + 1], argv[i + 2]});
+            i += 2;
+        } else if (arg == "--dead-reckoning" && has_value) {
+            dead_reckoning_ms = std::atoi(argv[++i]);
+        } else if (arg == "--reference-threshold" && i + 2 < argc) {
+            reference_threshold_mm = std::atof(argv[++i]);
+            reference_threshold_deg = std::atof(argv[++i]);
+        } else if (arg == "--check-alloc") {
+            vr_rt.check_allocations = true;
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+
+    bool valid_speed = replay_config.speed == 0.0 || (replay_config.speed >= 0.1 && replay_config.speed <= 100.0);
+    if (rate <= 0.0 || dead_reckoning_ms < 0 || !valid_speed || replay_config.seek < 0.0 || (synthetic && !replay_config.path.empty())) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
     Server::setupSignalHandlers();
+    // Keep stream I/O out of the VR and server loops
+    AsyncLogger::instance().start();
+    if (lock_memory) {
+        RealtimeUtils::lockMemory();
+    }
 
     std::mutex data_mutex;
     std::condition_variable data_cv;
-    VRControllerData shared_data;
+    TrackerSampleSlots shared_samples;
+
+    Recorder recorder;
+    DeviceMetadataTable metadata;
+    Calibration calibration;
+    if (!calibration_path.empty() && !calibration.load(calibration_path)) {
+        return EXIT_FAILURE;
+    }
+    PoseFilterConfig filter_config;
+    if (!filter_path.empty() && !filter_config.load(filter_path)) {
+        return EXIT_FAILURE;
+    }
 
-    Server server(12345, data_mutex, data_cv, shared_data);
+    Server server(12345, data_mutex, data_cv, shared_samples);
+    server.setRealtimeConfig(server_rt);
+    server.setDeviceMetadata(&metadata);
+    server.setExpectedPeriod(std::chrono::microseconds(static_cast<int64_t>(1e6 / rate)));
     std::thread serverThread(&Server::start, &server);
-    serverThread.detach(); // Detach the server thread
 
-    ViveInput vive_input(data_mutex, data_cv, shared_data);
-    vive_input.runVR();
+    int status = EXIT_SUCCESS;
+    try {
+        std::unique_ptr<PoseSource> source;
+        if (!replay_config.path.empty()) {
+            source = std::make_unique<ReplayPoseSource>(replay_config);
+        } else if (synthetic) {
+            source = std::make_unique<SyntheticPoseSource>(synthetic_config);
+        } else {
+            source = std::make_unique<OpenVRPoseSource>();
+        }
+        ViveInput vive_input(std::move(source), data_mutex, data_cv, shared_samples);
+        vive_input.setRealtimeConfig(vr_rt);
+        vive_input.setRate(rate);
+        vive_input.setServer(&server);
+        vive_input.setReferenceThreshold(reference_threshold_mm / 1000.0, reference_threshold_deg * M_PI / 180.0);
+        vive_input.setDeviceMetadata(&metadata);
+        if (!record_path.empty()) {
+            if (!recorder.open(record_path, record_max_mb * 1024 * 1024)) {
+                throw std::runtime_error("Failed to open recording");
+            }
+            vive_input.setRecorder(&recorder);
+        }
+        if (!calibration_path.empty()) {
+            vive_input.setCalibration(&calibration);
+        }
+        if (!filter_path.empty()) {
+            vive_input.setPoseFilter(&filter_config);
+        }
+        // SIGHUP reloads the files given on the command line
+        ConfigReloader reloader(Server::reloadRequested(), calibration_path, filter_path);
+        if (!calibration_path.empty() || !filter_path.empty()) {
+            vive_input.setConfigReloader(&reloader);
+            reloader.start();
+        }
+        vive_input.setDeadReckoning(std::chrono::milliseconds(dead_reckoning_ms));
+        vive_input.setRelativePoses(relative_rules);
+        // Battery, serial, model and firmware at 1 Hz, off the VR thread
+        PropertyPoller poller(vive_input.poseSource(), metadata);
+        poller.setChangeCallback([&server] { server.notifyDeviceMetadata(); });
+        poller.start();
+
+        vive_input.runVR();
+    } catch (const std::runtime_error &e) {
+        // Return instead of terminating so the queued log messages get written
+        VIVE_LOG(Error, "%s", e.what());
+        status = EXIT_FAILURE;
+    }
 
+    server.stop();
     serverThread.join(); // Wait for the server thread to finish
+    recorder.close();
 
-    return 0;
+    return status;
 }
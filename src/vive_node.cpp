@@ -6,14 +6,28 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <cctype>
+#include <cstdio>
 #include "json.hpp" // Include nlohmann/json
 #include "VRUtils.hpp"
+#include "pose_history.hpp"
+#include "vive_messages.hpp"
 #include <tf2_ros/transform_broadcaster.h>
 #include <geometry_msgs/msg/transform_stamped.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
 #include "vive_ros2/msg/vr_controller_data.hpp"
+#include "vive_ros2/msg/vr_device_metadata.hpp"
+#include "vive_ros2/srv/lookup_pose.hpp"
 
 using json = nlohmann::json;
 
+// vive_input sends SteamVR axes; everything published here is REP-103, see vive_messages.hpp
+using vive_messages::convertAxes;
+
 class Client : public rclcpp::Node {
 private:
     int sock;
@@ -24,6 +38,17 @@ private:
     std::shared_ptr<tf2_ros::TransformBroadcaster> tf_broadcaster_;
     rclcpp::Publisher<geometry_msgs::msg::TransformStamped>::SharedPtr abs_transform_publisher_;
     rclcpp::Publisher<vive_ros2::msg::VRControllerData>::SharedPtr tracker_data_publisher_;
+    rclcpp::Publisher<geometry_msgs::msg::TwistStamped>::SharedPtr twist_publisher_;
+    rclcpp::Publisher<geometry_msgs::msg::TransformStamped>::SharedPtr reference_publisher_;
+    rclcpp::Publisher<geometry_msgs::msg::TransformStamped>::SharedPtr relative_publisher_;
+    rclcpp::Publisher<vive_ros2::msg::VRDeviceMetadata>::SharedPtr metadata_publisher_;
+    rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_publisher_;
+    std::map<uint32_t, std::string> device_serials; // from the metadata messages
+    std::mutex device_serials_mutex; // the lookup service reads device_serials from the spin thread
+    PoseHistory pose_history;        // REP-103 poses on the vive_input clock
+    std::string legacy_device;       // serial or index published on vive_pose_abs and vive_twist
+    int64_t legacy_index = -1;       // the first streamed device when legacy_device is empty
+    rclcpp::Service<vive_ros2::srv::LookupPose>::SharedPtr lookup_pose_service_;
 
     void connectToServer() {
         sock = socket(AF_INET, SOCK_STREAM, 0);
@@ -49,27 +74,39 @@ private:
         RCLCPP_INFO(this->get_logger(), "Reconnected to server.");
     }
 
-    void publishTransform(const VRControllerData& pose) {
-        geometry_msgs::msg::TransformStamped transformStamped;
-        transformStamped.header.stamp = this->now();
-        transformStamped.header.frame_id = "world";
-        transformStamped.child_frame_id = "vive_pose_abs";
-
-        transformStamped.transform.translation.x = -pose.pose_z;
-        transformStamped.transform.translation.y = -pose.pose_x;
-        transformStamped.transform.translation.z = pose.pose_y;
-        transformStamped.transform.rotation.x = -pose.pose_qz;
-        transformStamped.transform.rotation.y = -pose.pose_qx;
-        transformStamped.transform.rotation.z = pose.pose_qy;
-        transformStamped.transform.rotation.w = pose.pose_qw;
+    // Samples kept per tracker; interpolation needs two, and 2^20 (64 MB per
+    // tracker) is far more than any lookup window needs
+    size_t declarePoseHistorySize() {
+        int64_t size = this->declare_parameter<int64_t>("pose_history_size", 2048);
+        if (size < 2 || size > (int64_t(1) << 20)) {
+            RCLCPP_ERROR(this->get_logger(), "pose_history_size must be between 2 and 1048576, got %ld", static_cast<long>(size));
+            exit(EXIT_FAILURE);
+        }
+        return static_cast<size_t>(size);
+    }
 
-        // Publish to TF
-        tf_broadcaster_->sendTransform(transformStamped);
-        abs_transform_publisher_->publish(transformStamped);
+    // The device behind the single-device vive_pose_abs frame and topic and
+    // vive_twist: the legacy_device parameter (serial or index), or the first
+    // device that streams when it is empty
+    bool isLegacyDevice(uint32_t index, const std::string &serial) {
+        if (legacy_device.empty()) {
+            if (legacy_index < 0) {
+                legacy_index = index;
+                RCLCPP_INFO(this->get_logger(), "vive_pose_abs and vive_twist follow device %u", index);
+            }
+            return legacy_index == index;
+        }
+        if (legacy_device == serial) {
+            return true;
+        }
+        return std::isdigit(static_cast<unsigned char>(legacy_device[0])) && legacy_device == std::to_string(index);
     }
 
 public:
-    Client(std::string addr, int p) : Node("client_node"), sock(-1), address(addr), port(p) {
+    Client(std::string addr, int p) : Node("client_node"), sock(-1), address(addr), port(p),
+        pose_history(declarePoseHistorySize(),
+                     static_cast<int64_t>(this->declare_parameter<double>("max_extrapolation", 0.05) * 1e9)),
+        legacy_device(this->declare_parameter<std::string>("legacy_device", "")) {
         serv_addr.sin_family = AF_INET;
         serv_addr.sin_port = htons(port);
         if(inet_pton(AF_INET, address.c_str(), &serv_addr.sin_addr)<=0) {
@@ -79,6 +116,21 @@ public:
         tf_broadcaster_ = std::make_shared<tf2_ros::TransformBroadcaster>(this);
         abs_transform_publisher_ = this->create_publisher<geometry_msgs::msg::TransformStamped>("vive_pose_abs", 150);
         tracker_data_publisher_ = this->create_publisher<vive_ros2::msg::VRControllerData>("tracker_data", 10);
+        twist_publisher_ = this->create_publisher<geometry_msgs::msg::TwistStamped>("vive_twist", 150);
+        // Base stations, sent only when they move; latched for late subscribers
+        reference_publisher_ = this->create_publisher<geometry_msgs::msg::TransformStamped>(
+            "vive_tracking_references", rclcpp::QoS(16).transient_local());
+        // Device poses in the frame of a reference device, from the same vive_input poll
+        relative_publisher_ = this->create_publisher<geometry_msgs::msg::TransformStamped>("vive_relative_poses", 150);
+        // Battery, serial, model and firmware, sent on change (about 1 Hz at most)
+        metadata_publisher_ = this->create_publisher<vive_ros2::msg::VRDeviceMetadata>(
+            "vive_device_metadata", rclcpp::QoS(64).transient_local());
+        diagnostics_publisher_ = this->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+        lookup_pose_service_ = this->create_service<vive_ros2::srv::LookupPose>(
+            "lookup_pose", [this](const vive_ros2::srv::LookupPose::Request::SharedPtr request,
+                                  vive_ros2::srv::LookupPose::Response::SharedPtr response) {
+                handleLookupPose(*request, *response);
+            });
     }
 
     ~Client() {
@@ -87,32 +139,291 @@ public:
         }
     }
 
-    void publishTrackerData(const VRControllerData &data) {
-        // TODO Use the data from the pogo pin connector
+    // Every device on TF as world -> vive_tracker_<serial> and on tracker_data;
+    // the legacy device also as vive_pose_abs and on vive_twist
+    void publishTracker(const VRControllerData &data, const std::string &time) {
+        std::string serial = deviceSerial(data.device);
+        builtin_interfaces::msg::Time stamp = vive_messages::stampFromNs(data.time_ns);
         vive_ros2::msg::VRControllerData msg;
-        msg.grip_button = data.grip_button;
-        msg.trigger_button = data.trigger_button;
-        msg.trackpad_button = data.trackpad_button;
-        msg.trackpad_touch = data.trackpad_touch;
-        msg.menu_button = data.menu_button;
-        msg.trackpad_x = data.trackpad_x;
-        msg.trackpad_y = data.trackpad_y;
-        msg.trigger = data.trigger;
-        msg.role = data.role;
-        msg.time = data.time;
-
-        msg.abs_pose.header.stamp = this->get_clock()->now();
-        msg.abs_pose.header.frame_id = "world";
-        msg.abs_pose.child_frame_id = "vive_pose_abs";
-        msg.abs_pose.transform.translation.x = data.pose_x;
-        msg.abs_pose.transform.translation.y = data.pose_y;
-        msg.abs_pose.transform.translation.z = data.pose_z;
-        msg.abs_pose.transform.rotation.x = data.pose_qx;
-        msg.abs_pose.transform.rotation.y = data.pose_qy;
-        msg.abs_pose.transform.rotation.z = data.pose_qz;
-        msg.abs_pose.transform.rotation.w = data.pose_qw;
-
+        vive_messages::fillTrackerData(data, serial, time, stamp, msg);
+        tf_broadcaster_->sendTransform(msg.abs_pose);
         tracker_data_publisher_->publish(msg);
+
+        if (isLegacyDevice(data.device, serial)) {
+            geometry_msgs::msg::TransformStamped alias = msg.abs_pose;
+            alias.child_frame_id = "vive_pose_abs";
+            tf_broadcaster_->sendTransform(alias);
+            abs_transform_publisher_->publish(alias);
+            geometry_msgs::msg::TwistStamped twistStamped;
+            vive_messages::fillTwist(data, stamp, twistStamped);
+            twist_publisher_->publish(twistStamped);
+        }
+    }
+
+    void handleMessage(const std::string &message) {
+        try {
+            json j = json::parse(message);
+            std::string type = j.value("type", "tracker");
+            if (type == "tracker") {
+                handleTrackerMessage(j);
+            } else if (type == "relative_pose") {
+                handleRelativePoseMessage(j);
+            } else if (type == "tracking_reference") {
+                handleTrackingReferenceMessage(j);
+            } else if (type == "device_metadata") {
+                handleDeviceMetadataMessage(j);
+            } else if (type == "tracking_quality") {
+                handleTrackingQualityMessage(j);
+            } else if (type == "status") {
+                std::string source = j["source"];
+                if (j["available"]) {
+                    RCLCPP_INFO(this->get_logger(), "Pose source %s available", source.c_str());
+                } else {
+                    RCLCPP_WARN(this->get_logger(), "Pose source %s unavailable, waiting for it to come back", source.c_str());
+                }
+            } else {
+                RCLCPP_DEBUG(this->get_logger(), "Ignoring message of type %s", type.c_str());
+            }
+        } catch (json::exception& e) {
+            RCLCPP_ERROR(this->get_logger(), "JSON parse error: %s", e.what());
+        }
+    }
+
+    void handleTrackerMessage(const json &j) {
+        // Store JSON data to the struct
+        jsonData.time_ns = j["time_ns"];
+        jsonData.device = j["device"];
+        jsonData.pose_x = j["pose"]["x"];
+        jsonData.pose_y = j["pose"]["y"];
+        jsonData.pose_z = j["pose"]["z"];
+        jsonData.pose_qx = j["pose"]["qx"];
+        jsonData.pose_qy = j["pose"]["qy"];
+        jsonData.pose_qz = j["pose"]["qz"];
+        jsonData.pose_qw = j["pose"]["qw"];
+        jsonData.raw_x = j["raw_pose"]["x"];
+        jsonData.raw_y = j["raw_pose"]["y"];
+        jsonData.raw_z = j["raw_pose"]["z"];
+        jsonData.raw_qx = j["raw_pose"]["qx"];
+        jsonData.raw_qy = j["raw_pose"]["qy"];
+        jsonData.raw_qz = j["raw_pose"]["qz"];
+        jsonData.raw_qw = j["raw_pose"]["qw"];
+        jsonData.vel_x = j["velocity"]["x"];
+        jsonData.vel_y = j["velocity"]["y"];
+        jsonData.vel_z = j["velocity"]["z"];
+        jsonData.ang_vel_x = j["angular_velocity"]["x"];
+        jsonData.ang_vel_y = j["angular_velocity"]["y"];
+        jsonData.ang_vel_z = j["angular_velocity"]["z"];
+
+        const json &buttons = j["buttons"];
+        jsonData.buttons = (buttons["menu"].get<bool>() ? ButtonMenu : 0) | (buttons["trigger"].get<bool>() ? ButtonTrigger : 0) |
+                           (buttons["trackpad_touch"].get<bool>() ? ButtonTrackpadTouch : 0) |
+                           (buttons["trackpad_button"].get<bool>() ? ButtonTrackpad : 0) | (buttons["grip"].get<bool>() ? ButtonGrip : 0);
+        jsonData.trackpad_x = j["trackpad"]["x"];
+        jsonData.trackpad_y = j["trackpad"]["y"];
+        jsonData.trigger = j["trigger"];
+        jsonData.pressed_edges = j["edges"]["pressed"];
+        jsonData.released_edges = j["edges"]["released"];
+        jsonData.role = j["role"];
+        jsonData.flags = j["predicted"].get<bool>() ? TrackerPredicted : 0;
+        const std::string &time = j["time"].get_ref<const std::string&>();
+        convertAxes(jsonData);
+        pose_history.add(jsonData.device, TimedPose{jsonData.time_ns, {jsonData.pose_x, jsonData.pose_y, jsonData.pose_z},
+                                                    {jsonData.pose_qw, jsonData.pose_qx, jsonData.pose_qy, jsonData.pose_qz}});
+        // Example of using stored data
+        RCLCPP_DEBUG(this->get_logger(), "Time: %s", time.c_str());
+        RCLCPP_DEBUG(this->get_logger(), "Device: %u", jsonData.device);
+        RCLCPP_DEBUG(this->get_logger(), "Pose x: %f", jsonData.pose_x);
+        RCLCPP_DEBUG(this->get_logger(), "Pose y: %f", jsonData.pose_y);
+        RCLCPP_DEBUG(this->get_logger(), "Pose z: %f", jsonData.pose_z);
+
+        RCLCPP_DEBUG(this->get_logger(), "Menu button: %s", (jsonData.buttons & ButtonMenu) ? "true" : "false");
+        RCLCPP_DEBUG(this->get_logger(), "Trigger button: %s", (jsonData.buttons & ButtonTrigger) ? "true" : "false");
+        RCLCPP_DEBUG(this->get_logger(), "Trackpad touch: %s", (jsonData.buttons & ButtonTrackpadTouch) ? "true" : "false");
+        RCLCPP_DEBUG(this->get_logger(), "Trackpad button: %s", (jsonData.buttons & ButtonTrackpad) ? "true" : "false");
+        RCLCPP_DEBUG(this->get_logger(), "Grip button: %s", (jsonData.buttons & ButtonGrip) ? "true" : "false");
+        
+        RCLCPP_DEBUG(this->get_logger(), "Trackpad x: %f", jsonData.trackpad_x);
+        RCLCPP_DEBUG(this->get_logger(), "Trackpad y: %f", jsonData.trackpad_y);
+        RCLCPP_DEBUG(this->get_logger(), "Trigger: %f", jsonData.trigger);
+        RCLCPP_DEBUG(this->get_logger(), "Edges: pressed 0x%02x released 0x%02x", jsonData.pressed_edges, jsonData.released_edges);
+        RCLCPP_DEBUG(this->get_logger(), "Role: %d", jsonData.role);
+
+        publishTracker(jsonData, time);
+    }
+
+    // Serial number of a device once its metadata has arrived, empty before
+    std::string deviceSerial(uint32_t index) {
+        std::lock_guard<std::mutex> lock(device_serials_mutex);
+        auto serial = device_serials.find(index);
+        return serial != device_serials.end() ? serial->second : std::string();
+    }
+
+    std::string trackerFrame(uint32_t index) {
+        return vive_messages::trackerFrame(index, deviceSerial(index));
+    }
+
+    void handleRelativePoseMessage(const json &j) {
+        RelativePoseData data;
+        data.time_ns = j["time_ns"];
+        data.device = j["device"];
+        data.reference = j["reference"];
+        data.pose_x = j["pose"]["x"];
+        data.pose_y = j["pose"]["y"];
+        data.pose_z = j["pose"]["z"];
+        data.pose_qx = j["pose"]["qx"];
+        data.pose_qy = j["pose"]["qy"];
+        data.pose_qz = j["pose"]["qz"];
+        data.pose_qw = j["pose"]["qw"];
+        convertAxes(data);
+
+        geometry_msgs::msg::TransformStamped transformStamped;
+        transformStamped.header.stamp = vive_messages::stampFromNs(data.time_ns);
+        transformStamped.header.frame_id = trackerFrame(data.reference);
+        transformStamped.child_frame_id = trackerFrame(data.device);
+        transformStamped.transform.translation.x = data.pose_x;
+        transformStamped.transform.translation.y = data.pose_y;
+        transformStamped.transform.translation.z = data.pose_z;
+        transformStamped.transform.rotation.x = data.pose_qx;
+        transformStamped.transform.rotation.y = data.pose_qy;
+        transformStamped.transform.rotation.z = data.pose_qz;
+        transformStamped.transform.rotation.w = data.pose_qw;
+
+        tf_broadcaster_->sendTransform(transformStamped);
+        relative_publisher_->publish(transformStamped);
+    }
+
+    void handleTrackingReferenceMessage(const json &j) {
+        TrackingReferenceData data;
+        data.index = j["index"];
+        data.valid = j["valid"];
+        data.serial = j["serial"];
+        data.time = j["time"];
+        data.time_ns = j["time_ns"];
+        data.pose_x = j["pose"]["x"];
+        data.pose_y = j["pose"]["y"];
+        data.pose_z = j["pose"]["z"];
+        data.pose_qx = j["pose"]["qx"];
+        data.pose_qy = j["pose"]["qy"];
+        data.pose_qz = j["pose"]["qz"];
+        data.pose_qw = j["pose"]["qw"];
+        convertAxes(data);
+
+        if (!data.valid) {
+            RCLCPP_WARN(this->get_logger(), "Base station %s lost", data.serial.c_str());
+            return;
+        }
+        RCLCPP_INFO(this->get_logger(), "Base station %s at %.3f %.3f %.3f", data.serial.c_str(), data.pose_x, data.pose_y, data.pose_z);
+
+        geometry_msgs::msg::TransformStamped transformStamped;
+        transformStamped.header.stamp = vive_messages::stampFromNs(data.time_ns);
+        transformStamped.header.frame_id = "world";
+        transformStamped.child_frame_id = "vive_base_station_" + (data.serial.empty() ? std::to_string(data.index) : data.serial);
+        transformStamped.transform.translation.x = data.pose_x;
+        transformStamped.transform.translation.y = data.pose_y;
+        transformStamped.transform.translation.z = data.pose_z;
+        transformStamped.transform.rotation.x = data.pose_qx;
+        transformStamped.transform.rotation.y = data.pose_qy;
+        transformStamped.transform.rotation.z = data.pose_qz;
+        transformStamped.transform.rotation.w = data.pose_qw;
+
+        tf_broadcaster_->sendTransform(transformStamped);
+        reference_publisher_->publish(transformStamped);
+    }
+
+    void handleDeviceMetadataMessage(const json &j) {
+        vive_ros2::msg::VRDeviceMetadata msg;
+        msg.header.stamp = this->now();
+        msg.index = j["index"];
+        msg.connected = j["connected"];
+        msg.device_class = j["device_class"];
+        msg.serial = j["serial"];
+        msg.model = j["model"];
+        msg.firmware = j["firmware"];
+        msg.provides_battery = j["provides_battery"];
+        msg.battery = j["battery"];
+        msg.charging = j["charging"];
+        RCLCPP_DEBUG(this->get_logger(), "Device %u %s: battery %.0f%%", msg.index, msg.serial.c_str(), msg.battery * 100.0);
+        {
+            std::lock_guard<std::mutex> lock(device_serials_mutex);
+            device_serials[msg.index] = msg.serial;
+        }
+        metadata_publisher_->publish(msg);
+    }
+
+    // One diagnostic status per device and window, graded by the share of valid poses
+    void handleTrackingQualityMessage(const json &j) {
+        diagnostic_msgs::msg::DiagnosticArray array;
+        array.header.stamp = this->now();
+        for (const auto &device : j["devices"]) {
+            uint32_t index = device["index"];
+            double valid_fraction = device["valid_fraction"];
+            double longest_gap = device["longest_gap"];
+            auto serial = device_serials.find(index);
+
+            diagnostic_msgs::msg::DiagnosticStatus status;
+            status.hardware_id = serial != device_serials.end() ? serial->second : std::to_string(index);
+            status.name = "vive_ros2: tracking " + status.hardware_id;
+            if (valid_fraction >= 0.99) {
+                status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+            } else if (valid_fraction >= 0.9) {
+                status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+            } else {
+                status.level = diagnostic_msgs::msg::DiagnosticStatus::ERROR;
+            }
+            char message[128];
+            std::snprintf(message, sizeof(message), "%.1f%% valid poses, longest gap %.3f s", valid_fraction * 100.0, longest_gap);
+            status.message = message;
+
+            auto add = [&status](const std::string &key, const std::string &value) {
+                diagnostic_msgs::msg::KeyValue kv;
+                kv.key = key;
+                kv.value = value;
+                status.values.push_back(kv);
+            };
+            add("window", j["window"].dump());
+            add("samples", device["samples"].dump());
+            add("valid_rate", device["valid_rate"].dump());
+            add("longest_gap", device["longest_gap"].dump());
+            for (const auto &state : device["states"].items()) {
+                add(state.key() + "_count", state.value()["count"].dump());
+                add(state.key() + "_duration", state.value()["duration"].dump());
+            }
+            array.status.push_back(status);
+        }
+        diagnostics_publisher_->publish(array);
+    }
+
+    void handleLookupPose(const vive_ros2::srv::LookupPose::Request &request, vive_ros2::srv::LookupPose::Response &response) {
+        uint32_t index = request.index;
+        if (!request.serial.empty()) {
+            std::lock_guard<std::mutex> lock(device_serials_mutex);
+            auto it = std::find_if(device_serials.begin(), device_serials.end(),
+                                   [&request](const std::pair<const uint32_t, std::string> &entry) { return entry.second == request.serial; });
+            if (it == device_serials.end()) {
+                response.success = false;
+                response.message = "unknown serial " + request.serial;
+                return;
+            }
+            index = it->first;
+        }
+        TimedPose pose;
+        PoseHistory::Result result = pose_history.lookup(index, rclcpp::Time(request.stamp).nanoseconds(), pose);
+        response.success = result == PoseHistory::Interpolated || result == PoseHistory::Extrapolated;
+        response.extrapolated = result == PoseHistory::Extrapolated;
+        response.message = PoseHistory::resultName(result);
+        if (!response.success) {
+            return;
+        }
+        response.pose.header.stamp = request.stamp;
+        response.pose.header.frame_id = "world";
+        response.pose.child_frame_id = trackerFrame(index);
+        response.pose.transform.translation.x = pose.position.x;
+        response.pose.transform.translation.y = pose.position.y;
+        response.pose.transform.translation.z = pose.position.z;
+        response.pose.transform.rotation.x = pose.orientation.x;
+        response.pose.transform.rotation.y = pose.orientation.y;
+        response.pose.transform.rotation.z = pose.orientation.z;
+        response.pose.transform.rotation.w = pose.orientation.w;
     }
 
     void start() {
@@ -122,62 +433,22 @@ public:
         }
         RCLCPP_INFO(this->get_logger(), "Connected to server.");
 
-        char buffer[1024] = {0};
+        char buffer[4096];
+        std::string pending; // Messages are newline-delimited and may span reads
         while (rclcpp::ok()) {
-            memset(buffer, 0, sizeof(buffer)); // Clear buffer
-            int bytesReceived = read(sock, buffer, 1024);
+            int bytesReceived = read(sock, buffer, sizeof(buffer));
             if (bytesReceived > 0) {
-                std::string receivedData(buffer, bytesReceived);
-                try {
-                    json j = json::parse(receivedData);
-                    // Store JSON data to the struct
-                    jsonData.pose_x = j["pose"]["x"];
-                    jsonData.pose_y = j["pose"]["y"];
-                    jsonData.pose_z = j["pose"]["z"];
-                    jsonData.pose_qx = j["pose"]["qx"];
-                    jsonData.pose_qy = j["pose"]["qy"];
-                    jsonData.pose_qz = j["pose"]["qz"];
-                    jsonData.pose_qw = j["pose"]["qw"];
-
-                    // TODO Use the data from the pogo pin connector
-                    jsonData.menu_button = j["buttons"]["menu"];
-                    jsonData.trigger_button = j["buttons"]["trigger"];
-                    jsonData.trackpad_touch = j["buttons"]["trackpad_touch"];
-                    jsonData.trackpad_button = j["buttons"]["trackpad_button"];
-                    jsonData.grip_button = j["buttons"]["grip"];
-                    jsonData.trackpad_x = j["trackpad"]["x"];
-                    jsonData.trackpad_y = j["trackpad"]["y"];
-                    jsonData.trigger = j["trigger"];
-                    jsonData.role = j["role"];
-                    jsonData.time = j["time"];
-                    // Example of using stored data
-                    RCLCPP_DEBUG(this->get_logger(), "Time: %s", jsonData.time.c_str());
-                    RCLCPP_DEBUG(this->get_logger(), "Pose x: %f", jsonData.pose_x);
-                    RCLCPP_DEBUG(this->get_logger(), "Pose y: %f", jsonData.pose_y);
-                    RCLCPP_DEBUG(this->get_logger(), "Pose z: %f", jsonData.pose_z);
-
-                    RCLCPP_DEBUG(this->get_logger(), "Menu button: %s", jsonData.menu_button ? "true" : "false");
-                    RCLCPP_DEBUG(this->get_logger(), "Trigger button: %s", jsonData.trigger_button ? "true" : "false");
-                    RCLCPP_DEBUG(this->get_logger(), "Trackpad touch: %s", jsonData.trackpad_touch ? "true" : "false");
-                    RCLCPP_DEBUG(this->get_logger(), "Trackpad button: %s", jsonData.trackpad_button ? "true" : "false");
-                    RCLCPP_DEBUG(this->get_logger(), "Grip button: %s", jsonData.grip_button ? "true" : "false");
-                    
-                    RCLCPP_DEBUG(this->get_logger(), "Trackpad x: %f", jsonData.trackpad_x);
-                    RCLCPP_DEBUG(this->get_logger(), "Trackpad y: %f", jsonData.trackpad_y);
-                    RCLCPP_DEBUG(this->get_logger(), "Trigger: %f", jsonData.trigger);
-                    RCLCPP_DEBUG(this->get_logger(), "Role: %d", jsonData.role);
-
-                    // Publish the absolute transform
-                    publishTransform(jsonData);
-                    // Publish tracker data
-                    publishTrackerData(jsonData);
-
-                } catch (json::parse_error& e) {
-                    RCLCPP_ERROR(this->get_logger(), "JSON parse error: %s", e.what());
-                    continue;
+                pending.append(buffer, bytesReceived);
+                size_t begin = 0;
+                size_t end;
+                while ((end = pending.find('\n', begin)) != std::string::npos) {
+                    handleMessage(pending.substr(begin, end - begin));
+                    begin = end + 1;
                 }
+                pending.erase(0, begin);
             } else if (bytesReceived == 0) {
                 RCLCPP_WARN(this->get_logger(), "Connection closed by server. Attempting to reconnect...");
+                pending.clear();
                 reconnect();
             } else {
                 RCLCPP_ERROR(this->get_logger(), "Read error.");
@@ -190,8 +461,10 @@ public:
 int main(int argc, char **argv) {
     rclcpp::init(argc, argv);
     auto client = std::make_shared<Client>("127.0.0.1", 12345);
+    // The socket loop blocks, services are served from their own thread
+    std::thread spinner([client] { rclcpp::spin(client); });
     client->start();
-    rclcpp::spin(client);
     rclcpp::shutdown();
+    spinner.join();
     return 0;
 }
@@ -0,0 +1,47 @@
+#ifndef VIVE_TEST_CHECK_HPP
+#define VIVE_TEST_CHECK_HPP
+
+#include <cmath>
+#include <cstdio>
+
+// Checks for the test executables: a failure prints the expression and
+// location and is counted, the test's main returns checkResult() for ctest.
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline void checkFailed(const char* file, int line, const char* expression, double a = NAN, double b = NAN) {
+    checkFailures()++;
+    if (std::isnan(a) && std::isnan(b)) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    } else {
+        std::fprintf(stderr, "%s:%d: check failed: %s (%.9g vs %.9g)\n", file, line, expression, a, b);
+    }
+}
+
+inline int checkResult(const char* name) {
+    if (checkFailures() == 0) {
+        std::printf("%s: all checks passed\n", name);
+        return 0;
+    }
+    std::printf("%s: %d checks failed\n", name, checkFailures());
+    return 1;
+}
+
+#define CHECK(condition)                                   \
+    do {                                                   \
+        if (!(condition)) {                                \
+            checkFailed(__FILE__, __LINE__, #condition);   \
+        }                                                  \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tolerance)                                                     \
+    do {                                                                                \
+        double check_a_ = (a), check_b_ = (b);                                          \
+        if (!(std::fabs(check_a_ - check_b_) <= (tolerance))) {                         \
+            checkFailed(__FILE__, __LINE__, #a " == " #b " within " #tolerance, check_a_, check_b_); \
+        }                                                                               \
+    } while (0)
+
+#endif // VIVE_TEST_CHECK_HPP
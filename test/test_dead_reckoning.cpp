@@ -0,0 +1,133 @@
+// DeadReckoning through a dropout: the pose is extrapolated with the last
+// velocities inside the window, reported Lost past it, and when tracking
+// returns the prediction fades into the measurement over the window.
+
+#include <cstring>
+
+#include "VRUtils.hpp"
+#include "check.hpp"
+#include "dead_reckoning.hpp"
+
+using transform::Quaternion;
+using transform::RigidTransform;
+using transform::Vector3;
+
+namespace {
+
+constexpr int64_t kMs = 1000000;
+constexpr int64_t kWindow = 50 * kMs;
+constexpr double kTolerance = 1e-5;
+
+const Vector3<float> kZ{0.0f, 0.0f, 1.0f};
+
+// Tracker at x, turned yaw about z, moving at vx along x and turning at wz about z
+vr::TrackedDevicePose_t trackedPose(float x, float yaw, float vx, float wz) {
+    vr::TrackedDevicePose_t pose;
+    std::memset(&pose, 0, sizeof(pose));
+    pose.bDeviceIsConnected = true;
+    pose.bPoseIsValid = true;
+    pose.eTrackingResult = vr::TrackingResult_Running_OK;
+    pose.mDeviceToAbsoluteTracking = VRTransformUtils::ToMatrix34(
+        RigidTransform<float>::fromQuaternion(Quaternion<float>::fromAxisAngle(kZ, yaw), {x, 0.0f, 0.0f}));
+    pose.vVelocity = {{vx, 0.0f, 0.0f}};
+    pose.vAngularVelocity = {{0.0f, 0.0f, wz}};
+    return pose;
+}
+
+vr::TrackedDevicePose_t droppedPose() {
+    vr::TrackedDevicePose_t pose = trackedPose(0.0f, 0.0f, 0.0f, 0.0f);
+    pose.bPoseIsValid = false;
+    pose.eTrackingResult = vr::TrackingResult_Running_OutOfRange;
+    return pose;
+}
+
+void checkPose(const vr::TrackedDevicePose_t& pose, float x, float yaw) {
+    RigidTransform<float> t = VRTransformUtils::ToRigidTransform(pose.mDeviceToAbsoluteTracking);
+    CHECK_NEAR(t.translation.x, x, kTolerance);
+    CHECK_NEAR(t.translation.y, 0.0, kTolerance);
+    CHECK_NEAR(t.translation.z, 0.0, kTolerance);
+    // q and -q are the same rotation
+    CHECK_NEAR(std::fabs(t.orientation().dot(Quaternion<float>::fromAxisAngle(kZ, yaw))), 1.0, kTolerance);
+}
+
+// Moving at 1 m/s and 2 rad/s, tracked until t = 10 ms
+void trackUntil10ms(DeadReckoning& reckoning) {
+    for (int64_t t = 0; t <= 10; t++) {
+        vr::TrackedDevicePose_t pose = trackedPose(0.001f * t, 0.002f * t, 1.0f, 2.0f);
+        CHECK(reckoning.update(t * kMs, kWindow, pose) == DeadReckoning::Tracked);
+        checkPose(pose, 0.001f * t, 0.002f * t);
+    }
+}
+
+void testPrediction() {
+    DeadReckoning reckoning;
+    trackUntil10ms(reckoning);
+
+    // 20 ms into the dropout: 2 cm further along x and 0.04 rad further round z
+    vr::TrackedDevicePose_t pose = droppedPose();
+    CHECK(reckoning.update(30 * kMs, kWindow, pose) == DeadReckoning::Predicted);
+    CHECK(pose.bPoseIsValid);
+    checkPose(pose, 0.030f, 0.060f);
+    CHECK(pose.vVelocity.v[0] == 1.0f);
+    CHECK(pose.vAngularVelocity.v[2] == 2.0f);
+
+    // Still inside the window at its very end
+    pose = droppedPose();
+    CHECK(reckoning.update(60 * kMs, kWindow, pose) == DeadReckoning::Predicted);
+    checkPose(pose, 0.060f, 0.120f);
+}
+
+void testLost() {
+    DeadReckoning reckoning;
+    trackUntil10ms(reckoning);
+
+    vr::TrackedDevicePose_t pose = droppedPose();
+    CHECK(reckoning.update(61 * kMs, kWindow, pose) == DeadReckoning::Lost);
+    CHECK(!pose.bPoseIsValid);
+    pose = droppedPose();
+    CHECK(reckoning.update(70 * kMs, kWindow, pose) == DeadReckoning::Lost);
+
+    // Nothing to extrapolate from before the first tracked pose, or after reset()
+    DeadReckoning fresh;
+    pose = droppedPose();
+    CHECK(fresh.update(0, kWindow, pose) == DeadReckoning::Lost);
+    reckoning.reset();
+    pose = droppedPose();
+    CHECK(reckoning.update(71 * kMs, kWindow, pose) == DeadReckoning::Lost);
+}
+
+// Tracking returns 10 cm and 0.1 rad off the last prediction: the first pose
+// is that prediction, halfway through the window half the offset is left, and
+// after the window the measurement comes through unchanged
+void testBlend() {
+    DeadReckoning reckoning;
+    trackUntil10ms(reckoning);
+    vr::TrackedDevicePose_t pose = droppedPose();
+    CHECK(reckoning.update(20 * kMs, kWindow, pose) == DeadReckoning::Predicted);
+    checkPose(pose, 0.020f, 0.040f);
+
+    const float x = 0.120f, yaw = 0.140f;
+    pose = trackedPose(x, yaw, 0.0f, 0.0f);
+    CHECK(reckoning.update(30 * kMs, kWindow, pose) == DeadReckoning::Tracked);
+    checkPose(pose, 0.020f, 0.040f);
+
+    pose = trackedPose(x, yaw, 0.0f, 0.0f);
+    CHECK(reckoning.update(55 * kMs, kWindow, pose) == DeadReckoning::Tracked);
+    checkPose(pose, x - 0.050f, yaw - 0.050f);
+
+    pose = trackedPose(x, yaw, 0.0f, 0.0f);
+    CHECK(reckoning.update(80 * kMs, kWindow, pose) == DeadReckoning::Tracked);
+    checkPose(pose, x, yaw);
+    pose = trackedPose(x, yaw, 0.0f, 0.0f);
+    CHECK(reckoning.update(81 * kMs, kWindow, pose) == DeadReckoning::Tracked);
+    checkPose(pose, x, yaw);
+}
+
+} // namespace
+
+int main() {
+    testPrediction();
+    testLost();
+    testBlend();
+    return checkResult("test_dead_reckoning");
+}
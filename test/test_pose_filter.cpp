@@ -0,0 +1,131 @@
+// PoseFilter on fixed inputs: the first sample and constant poses pass
+// through, a high cutoff follows moving input, a low cutoff smooths a step
+// by the One-Euro smoothing factor, and a timestamp that does not advance
+// holds the previous output.
+
+#include "check.hpp"
+#include "pose_filter.hpp"
+
+using transform::Quaternion;
+using transform::Vector3;
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr int64_t kMs = 1000000;
+constexpr double kTolerance = 1e-12;
+
+const Vector3<double> kZ{0.0, 0.0, 1.0};
+
+PoseFilterConfig config(double min_cutoff, double beta) {
+    PoseFilterConfig c;
+    c.position.min_cutoff = c.rotation.min_cutoff = min_cutoff;
+    c.position.beta = c.rotation.beta = beta;
+    return c;
+}
+
+void checkVector(const Vector3<double>& a, const Vector3<double>& b, double tolerance) {
+    CHECK_NEAR(a.x, b.x, tolerance);
+    CHECK_NEAR(a.y, b.y, tolerance);
+    CHECK_NEAR(a.z, b.z, tolerance);
+}
+
+void checkRotation(const Quaternion<double>& a, const Quaternion<double>& b, double tolerance) {
+    CHECK_NEAR((a.conjugate() * b).angle(), 0.0, tolerance);
+}
+
+void testAtRest() {
+    PoseFilterConfig c = config(1.0, 0.5);
+    PoseFilter filter;
+    const Vector3<double> p0{1.0, -2.0, 0.5};
+    const Quaternion<double> q0 = Quaternion<double>::fromAxisAngle(kZ, 0.7);
+    for (int64_t k = 0; k < 100; k++) {
+        Vector3<double> p = p0;
+        Quaternion<double> q = q0;
+        filter.filter(c, k * kMs, p, q);
+        checkVector(p, p0, kTolerance);
+        checkRotation(q, q0, 1e-7);
+        CHECK(q.w >= 0.0);
+    }
+}
+
+// At 1 MHz the smoothing factor is 1 - 2e-4 at 1 kHz, so a tracker moving
+// at 1 m/s and 1 rad/s is followed to within a fraction of a step
+void testHighCutoff() {
+    PoseFilterConfig c = config(1e6, 0.0);
+    PoseFilter filter;
+    for (int64_t k = 0; k < 100; k++) {
+        Vector3<double> truth{0.001 * k, 0.0, 0.0};
+        Quaternion<double> truth_q = Quaternion<double>::fromAxisAngle(kZ, 0.001 * k);
+        Vector3<double> p = truth;
+        Quaternion<double> q = truth_q;
+        filter.filter(c, k * kMs, p, q);
+        checkVector(p, truth, 1e-6);
+        checkRotation(q, truth_q, 1e-6);
+    }
+}
+
+// With beta = 0 the cutoff stays at min_cutoff: one 1 ms step of a 1 m
+// jump moves the output by alpha = 1 / (1 + 1 / (2 pi fc dt))
+void testLowCutoff() {
+    PoseFilterConfig c = config(1.0, 0.0);
+    PoseFilter filter;
+    Vector3<double> p{0.0, 0.0, 0.0};
+    Quaternion<double> q = Quaternion<double>::identity();
+    filter.filter(c, 0, p, q);
+
+    double alpha = 1.0 / (1.0 + 1.0 / (2.0 * kPi * 1.0 * 0.001));
+    p = {1.0, 0.0, 0.0};
+    q = Quaternion<double>::fromAxisAngle(kZ, 1.0);
+    filter.filter(c, kMs, p, q);
+    checkVector(p, {alpha, 0.0, 0.0}, kTolerance);
+    checkRotation(q, Quaternion<double>::fromAxisAngle(kZ, alpha), 1e-7);
+
+    // After reset() the next sample passes through unfiltered
+    filter.reset();
+    p = {1.0, 0.0, 0.0};
+    q = Quaternion<double>::fromAxisAngle(kZ, 1.0);
+    filter.filter(c, 2 * kMs, p, q);
+    checkVector(p, {1.0, 0.0, 0.0}, kTolerance);
+    checkRotation(q, Quaternion<double>::fromAxisAngle(kZ, 1.0), 1e-7);
+}
+
+// A repeated or older timestamp has no dt to filter with: the previous
+// output is returned and the state is left as it was
+void testTimeNotAdvancing() {
+    PoseFilterConfig c = config(1.0, 0.0);
+    PoseFilter filter;
+    Vector3<double> p{0.0, 0.0, 0.0};
+    Quaternion<double> q = Quaternion<double>::identity();
+    filter.filter(c, 10 * kMs, p, q);
+    p = {1.0, 0.0, 0.0};
+    q = Quaternion<double>::fromAxisAngle(kZ, 1.0);
+    filter.filter(c, 11 * kMs, p, q);
+    const Vector3<double> held = p;
+    const Quaternion<double> held_q = q;
+
+    for (int64_t t : {11 * kMs, 5 * kMs, int64_t(0)}) {
+        p = {-3.0, 4.0, 5.0};
+        q = Quaternion<double>::fromAxisAngle(kZ, -2.0);
+        filter.filter(c, t, p, q);
+        checkVector(p, held, 0.0);
+        CHECK(q.w == held_q.w && q.x == held_q.x && q.y == held_q.y && q.z == held_q.z);
+    }
+
+    // The next advancing sample continues from the held state
+    double alpha = 1.0 / (1.0 + 1.0 / (2.0 * kPi * 1.0 * 0.001));
+    p = {1.0, 0.0, 0.0};
+    q = held_q;
+    filter.filter(c, 12 * kMs, p, q);
+    checkVector(p, {held.x + (1.0 - held.x) * alpha, 0.0, 0.0}, kTolerance);
+}
+
+} // namespace
+
+int main() {
+    testAtRest();
+    testHighCutoff();
+    testLowCutoff();
+    testTimeNotAdvancing();
+    return checkResult("test_pose_filter");
+}
@@ -0,0 +1,142 @@
+// PoseHistory on a tracker moving at constant linear and angular velocity,
+// where interpolation and extrapolation are exact: lookups between and past
+// the samples, the extrapolation limits, a ring that has wrapped around, and
+// out-of-order samples being dropped.
+
+#include "check.hpp"
+#include "pose_history.hpp"
+
+using transform::Quaternion;
+using transform::Vector3;
+
+namespace {
+
+constexpr int64_t kMs = 1000000;
+constexpr int64_t kMaxExtrapolation = 50 * kMs;
+constexpr double kTolerance = 1e-9;
+
+// 1 m/s along x and 20 rad/s about z, so consecutive samples 10 ms apart
+// are 0.2 rad apart, past the linear fallback of slerp
+TimedPose poseAt(double ms) {
+    TimedPose pose;
+    pose.time_ns = static_cast<int64_t>(ms * kMs);
+    pose.position = {0.001 * ms, 0.0, 0.0};
+    pose.orientation = Quaternion<double>::fromAxisAngle({0.0, 0.0, 1.0}, 0.02 * ms);
+    return pose;
+}
+
+// Samples every 10 ms from first_ms to last_ms
+void addSamples(PoseHistory& history, uint32_t device, int first_ms, int last_ms) {
+    for (int ms = first_ms; ms <= last_ms; ms += 10) {
+        CHECK(history.add(device, poseAt(ms)));
+    }
+}
+
+void checkLookup(const PoseHistory& history, uint32_t device, double ms, PoseHistory::Result expected) {
+    TimedPose pose;
+    PoseHistory::Result result = history.lookup(device, static_cast<int64_t>(ms * kMs), pose);
+    CHECK(result == expected);
+    if (result != PoseHistory::Interpolated && result != PoseHistory::Extrapolated) {
+        return;
+    }
+    TimedPose truth = poseAt(ms);
+    CHECK(pose.time_ns == truth.time_ns);
+    CHECK_NEAR(pose.position.x, truth.position.x, kTolerance);
+    CHECK_NEAR(pose.position.y, 0.0, kTolerance);
+    // q and -q are the same rotation
+    CHECK_NEAR(std::fabs(pose.orientation.dot(truth.orientation)), 1.0, kTolerance);
+}
+
+void testInterpolation() {
+    PoseHistory history(16, kMaxExtrapolation);
+    addSamples(history, 3, 0, 90);
+    checkLookup(history, 3, 0, PoseHistory::Interpolated);
+    checkLookup(history, 3, 25, PoseHistory::Interpolated);
+    checkLookup(history, 3, 50, PoseHistory::Interpolated);
+    checkLookup(history, 3, 87.5, PoseHistory::Interpolated);
+    checkLookup(history, 3, 90, PoseHistory::Interpolated);
+
+    // Nothing for other devices, or past the last device index
+    checkLookup(history, 4, 50, PoseHistory::NoData);
+    checkLookup(history, PoseHistory::kMaxDevices, 50, PoseHistory::NoData);
+    CHECK(!history.add(PoseHistory::kMaxDevices, poseAt(0)));
+}
+
+// Up to max_extrapolation past either end, along the same line and arc
+void testExtrapolation() {
+    PoseHistory history(16, kMaxExtrapolation);
+    addSamples(history, 3, 100, 190);
+    checkLookup(history, 3, 220, PoseHistory::Extrapolated);
+    checkLookup(history, 3, 240, PoseHistory::Extrapolated);
+    checkLookup(history, 3, 241, PoseHistory::TooNew);
+    checkLookup(history, 3, 70, PoseHistory::Extrapolated);
+    checkLookup(history, 3, 50, PoseHistory::Extrapolated);
+    checkLookup(history, 3, 49, PoseHistory::TooOld);
+
+    // A single sample is held, there is no velocity to extrapolate with
+    PoseHistory single(16, kMaxExtrapolation);
+    CHECK(single.add(0, poseAt(100)));
+    TimedPose pose;
+    CHECK(single.lookup(0, 100 * kMs, pose) == PoseHistory::Interpolated);
+    CHECK(single.lookup(0, 130 * kMs, pose) == PoseHistory::Extrapolated);
+    CHECK(pose.time_ns == 130 * kMs);
+    CHECK_NEAR(pose.position.x, 0.1, kTolerance);
+    CHECK(single.lookup(0, 151 * kMs, pose) == PoseHistory::TooNew);
+}
+
+// Four slots after ten samples: 0..50 ms are overwritten, 60..90 ms remain,
+// with 80 ms back at the start of the buffer
+void testWrapAround() {
+    PoseHistory history(4, kMaxExtrapolation);
+    addSamples(history, 7, 0, 90);
+    int64_t oldest_ns = 0, newest_ns = 0;
+    CHECK(history.range(7, oldest_ns, newest_ns));
+    CHECK(oldest_ns == 60 * kMs);
+    CHECK(newest_ns == 90 * kMs);
+
+    checkLookup(history, 7, 60, PoseHistory::Interpolated);
+    checkLookup(history, 7, 65, PoseHistory::Interpolated);
+    checkLookup(history, 7, 75, PoseHistory::Interpolated);
+    checkLookup(history, 7, 85, PoseHistory::Interpolated);
+    checkLookup(history, 7, 30, PoseHistory::Extrapolated);
+    checkLookup(history, 7, 5, PoseHistory::TooOld);
+
+    // A capacity below two is raised to two
+    PoseHistory tiny(0, kMaxExtrapolation);
+    addSamples(tiny, 0, 0, 30);
+    CHECK(tiny.range(0, oldest_ns, newest_ns));
+    CHECK(oldest_ns == 20 * kMs && newest_ns == 30 * kMs);
+    checkLookup(tiny, 0, 25, PoseHistory::Interpolated);
+}
+
+void testOutOfOrder() {
+    PoseHistory history(16, kMaxExtrapolation);
+    addSamples(history, 2, 0, 90);
+    CHECK(!history.add(2, poseAt(90)));
+    CHECK(!history.add(2, poseAt(85)));
+    CHECK(!history.add(2, poseAt(0)));
+    int64_t oldest_ns = 0, newest_ns = 0;
+    CHECK(history.range(2, oldest_ns, newest_ns));
+    CHECK(oldest_ns == 0 && newest_ns == 90 * kMs);
+    checkLookup(history, 2, 85, PoseHistory::Interpolated);
+
+    // Other devices keep their own order
+    CHECK(history.add(5, poseAt(10)));
+
+    // After clear() the device starts over, earlier times included
+    history.clear(2);
+    CHECK(!history.range(2, oldest_ns, newest_ns));
+    checkLookup(history, 2, 50, PoseHistory::NoData);
+    addSamples(history, 2, 0, 20);
+    checkLookup(history, 2, 15, PoseHistory::Interpolated);
+}
+
+} // namespace
+
+int main() {
+    testInterpolation();
+    testExtrapolation();
+    testWrapAround();
+    testOutOfOrder();
+    return checkResult("test_pose_history");
+}
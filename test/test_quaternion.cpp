@@ -0,0 +1,181 @@
+// Checks the Shepperd quaternion extraction (transform::quaternionFromRotation,
+// VRTransformUtils::GetQuaternion, GetQuaternions and PoseBatch) against a
+// long double reference on float matrices as OpenVR delivers them, near 180
+// degrees included.
+
+#include <random>
+
+#include "VRUtils.hpp"
+#include "check.hpp"
+#include "pose_batch.hpp"
+
+namespace {
+
+using Real = long double;
+
+struct ReferenceQuaternion {
+    Real w, x, y, z;
+};
+
+// Textbook Shepperd with branches, in long double
+ReferenceQuaternion referenceQuaternion(const vr::HmdMatrix34_t& matrix) {
+    Real m[3][3];
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            m[r][c] = matrix.m[r][c];
+        }
+    }
+    Real trace = m[0][0] + m[1][1] + m[2][2];
+    ReferenceQuaternion q;
+    if (trace >= m[0][0] && trace >= m[1][1] && trace >= m[2][2]) {
+        Real s = 2 * std::sqrt(1 + trace);
+        q = {s / 4, (m[2][1] - m[1][2]) / s, (m[0][2] - m[2][0]) / s, (m[1][0] - m[0][1]) / s};
+    } else if (m[0][0] >= m[1][1] && m[0][0] >= m[2][2]) {
+        Real s = 2 * std::sqrt(1 + m[0][0] - m[1][1] - m[2][2]);
+        q = {(m[2][1] - m[1][2]) / s, s / 4, (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s};
+    } else if (m[1][1] >= m[2][2]) {
+        Real s = 2 * std::sqrt(1 - m[0][0] + m[1][1] - m[2][2]);
+        q = {(m[0][2] - m[2][0]) / s, (m[0][1] + m[1][0]) / s, s / 4, (m[1][2] + m[2][1]) / s};
+    } else {
+        Real s = 2 * std::sqrt(1 - m[0][0] - m[1][1] + m[2][2]);
+        q = {(m[1][0] - m[0][1]) / s, (m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, s / 4};
+    }
+    Real n = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    n = q.w < 0 ? -n : n;
+    return {q.w / n, q.x / n, q.y / n, q.z / n};
+}
+
+// Rotation matrix of a unit quaternion, rounded to float like the OpenVR poses
+vr::HmdMatrix34_t matrixFromQuaternion(const ReferenceQuaternion& q) {
+    vr::HmdMatrix34_t m;
+    m.m[0][0] = static_cast<float>(1 - 2 * (q.y * q.y + q.z * q.z));
+    m.m[0][1] = static_cast<float>(2 * (q.x * q.y - q.w * q.z));
+    m.m[0][2] = static_cast<float>(2 * (q.x * q.z + q.w * q.y));
+    m.m[1][0] = static_cast<float>(2 * (q.x * q.y + q.w * q.z));
+    m.m[1][1] = static_cast<float>(1 - 2 * (q.x * q.x + q.z * q.z));
+    m.m[1][2] = static_cast<float>(2 * (q.y * q.z - q.w * q.x));
+    m.m[2][0] = static_cast<float>(2 * (q.x * q.z - q.w * q.y));
+    m.m[2][1] = static_cast<float>(2 * (q.y * q.z + q.w * q.x));
+    m.m[2][2] = static_cast<float>(1 - 2 * (q.x * q.x + q.y * q.y));
+    m.m[0][3] = m.m[1][3] = m.m[2][3] = 0.0f;
+    return m;
+}
+
+// Rotation angle between two unit quaternions; |a - b| = 2 sin(angle / 4)
+// keeps precision for tiny angles where acos(dot) does not
+template <typename Q>
+Real angleBetween(const ReferenceQuaternion& a, const Q& b) {
+    Real sign = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z < 0 ? -1 : 1;
+    Real dw = a.w - sign * b.w, dx = a.x - sign * b.x, dy = a.y - sign * b.y, dz = a.z - sign * b.z;
+    Real half_chord = std::sqrt(dw * dw + dx * dx + dy * dy + dz * dz) / 2;
+    return 4 * std::asin(std::min<Real>(half_chord, 1));
+}
+
+template <typename Q>
+Real normError(const Q& q) {
+    return std::fabs(std::sqrt(Real(q.w) * q.w + Real(q.x) * q.x + Real(q.y) * q.y + Real(q.z) * q.z) - 1);
+}
+
+ReferenceQuaternion axisAngle(Real ax, Real ay, Real az, Real angle) {
+    Real n = std::sqrt(ax * ax + ay * ay + az * az);
+    Real s = std::sin(angle / 2) / n;
+    return {std::cos(angle / 2), ax * s, ay * s, az * s};
+}
+
+// One sample: the double extraction matches the reference on the same float
+// matrix to double precision, and the rotation it came from to float
+// precision; the float template to float precision
+void checkSample(const ReferenceQuaternion& q) {
+    vr::HmdMatrix34_t m = matrixFromQuaternion(q);
+    ReferenceQuaternion reference = referenceQuaternion(m);
+    vr::HmdQuaternion_t result = VRTransformUtils::GetQuaternion(m);
+    CHECK_NEAR(angleBetween(reference, result), 0.0, 1e-12);
+    CHECK_NEAR(angleBetween(q, result), 0.0, 5e-7);
+    CHECK_NEAR(normError(result), 0.0, 1e-15);
+    CHECK(result.w >= 0.0);
+
+    transform::Quaternion<float> single;
+    transform::quaternionFromRotation<float>(m.m[0][0], m.m[0][1], m.m[0][2], m.m[1][0], m.m[1][1], m.m[1][2],
+                                             m.m[2][0], m.m[2][1], m.m[2][2], single.w, single.x, single.y, single.z);
+    CHECK_NEAR(angleBetween(reference, single), 0.0, 1e-6);
+    CHECK_NEAR(normError(single), 0.0, 1e-6);
+}
+
+void testIdentity() {
+    vr::HmdMatrix34_t m = matrixFromQuaternion({1, 0, 0, 0});
+    vr::HmdQuaternion_t q = VRTransformUtils::GetQuaternion(m);
+    CHECK(q.w == 1.0 && q.x == 0.0 && q.y == 0.0 && q.z == 0.0);
+}
+
+// At 180 degrees w is 0 and the old copysign method lost the axis sign
+void testHalfTurns() {
+    const Real pi = std::acos(Real(-1));
+    checkSample(axisAngle(1, 0, 0, pi));
+    checkSample(axisAngle(0, 1, 0, pi));
+    checkSample(axisAngle(0, 0, 1, pi));
+    checkSample(axisAngle(1, -2, 3, pi));
+    std::mt19937 rng(41);
+    std::normal_distribution<double> gauss;
+    std::uniform_real_distribution<double> offset(0.0, 1e-3);
+    for (int k = 0; k < 20000; k++) {
+        checkSample(axisAngle(gauss(rng), gauss(rng), gauss(rng), pi - offset(rng)));
+    }
+}
+
+void testRandomRotations() {
+    std::mt19937 rng(4141);
+    std::normal_distribution<double> gauss;
+    for (int k = 0; k < 100000; k++) {
+        Real w = gauss(rng), x = gauss(rng), y = gauss(rng), z = gauss(rng);
+        Real n = std::sqrt(w * w + x * x + y * y + z * z);
+        checkSample({w / n, x / n, y / n, z / n});
+    }
+}
+
+// A slightly scaled and sheared matrix still gives a unit quaternion
+void testNotOrthonormal() {
+    vr::HmdMatrix34_t m = matrixFromQuaternion(axisAngle(0.3, 1, -0.2, 2.0));
+    m.m[0][0] *= 1.002f;
+    m.m[1][2] += 0.001f;
+    vr::HmdQuaternion_t q = VRTransformUtils::GetQuaternion(m);
+    CHECK_NEAR(normError(q), 0.0, 1e-15);
+    CHECK_NEAR(angleBetween(referenceQuaternion(m), q), 0.0, 1e-3);
+}
+
+// The batch over the pose array gives the same result as one call per pose
+void testBatch() {
+    std::mt19937 rng(64);
+    std::normal_distribution<double> gauss;
+    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+    for (auto& pose : poses) {
+        pose.mDeviceToAbsoluteTracking = matrixFromQuaternion(axisAngle(gauss(rng), gauss(rng), gauss(rng), 3.0 * gauss(rng)));
+    }
+    vr::HmdQuaternion_t batch[vr::k_unMaxTrackedDeviceCount];
+    VRTransformUtils::GetQuaternions(poses, vr::k_unMaxTrackedDeviceCount, batch);
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i++) {
+        vr::HmdQuaternion_t single = VRTransformUtils::GetQuaternion(poses[i].mDeviceToAbsoluteTracking);
+        CHECK(batch[i].w == single.w && batch[i].x == single.x && batch[i].y == single.y && batch[i].z == single.z);
+    }
+
+    // The acquisition loop's batch publishes the same orientations
+    PoseBatch pose_batch;
+    for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; i += 3) {
+        pose_batch.add(i, poses[i], 0);
+    }
+    for (uint32_t k = 0; k < pose_batch.count; k++) {
+        const vr::HmdQuaternion_t& single = batch[pose_batch.device[k]];
+        transform::Quaternion<double> q = pose_batch.quaternion(k);
+        CHECK(q.w == single.w && q.x == single.x && q.y == single.y && q.z == single.z);
+    }
+}
+
+} // namespace
+
+int main() {
+    testIdentity();
+    testHalfTurns();
+    testRandomRotations();
+    testNotOrthonormal();
+    testBatch();
+    return checkResult("test_quaternion");
+}
@@ -0,0 +1,119 @@
+// Records a short session with Recorder and plays it back through
+// ReplayPoseSource: poses come back as recorded, and with --replay-loop the
+// wrap-around is one frame without devices before the recording restarts.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "check.hpp"
+#include "recorder.hpp"
+#include "replay_pose_source.hpp"
+
+namespace {
+
+constexpr uint32_t kFrames = 3;
+constexpr vr::TrackedDeviceIndex_t kDevice = 2;
+
+// Tracker kDevice moves 1 m along x per frame, so the wrap is a 2 m jump
+std::string writeRecording() {
+    char path[] = "/tmp/test_replay_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+
+    Recorder recorder;
+    CHECK(recorder.open(path, kRecordingHeaderSize + 64 * sizeof(RecordedSample)));
+    for (uint32_t frame = 0; frame < kFrames; frame++) {
+        vr::TrackedDevicePose_t pose;
+        std::memset(&pose, 0, sizeof(pose));
+        pose.bDeviceIsConnected = true;
+        pose.bPoseIsValid = true;
+        pose.eTrackingResult = vr::TrackingResult_Running_OK;
+        pose.mDeviceToAbsoluteTracking.m[0][0] = pose.mDeviceToAbsoluteTracking.m[1][1] = pose.mDeviceToAbsoluteTracking.m[2][2] = 1.0f;
+        pose.mDeviceToAbsoluteTracking.m[0][3] = static_cast<float>(frame);
+        recorder.record(1000000 * (frame + 1), frame, kDevice, vr::TrackedDeviceClass_GenericTracker,
+                        vr::TrackedControllerRole_Invalid, pose, nullptr);
+    }
+    CHECK(recorder.recordCount() == kFrames);
+    recorder.close();
+    return path;
+}
+
+void checkFrame(ReplayPoseSource& source, float x) {
+    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+    source.getPoses(poses, vr::k_unMaxTrackedDeviceCount);
+    CHECK(poses[kDevice].bDeviceIsConnected && poses[kDevice].bPoseIsValid);
+    CHECK(poses[kDevice].mDeviceToAbsoluteTracking.m[0][3] == x);
+    CHECK(source.getDeviceClass(kDevice) == vr::TrackedDeviceClass_GenericTracker);
+    CHECK(!poses[0].bDeviceIsConnected);
+}
+
+void checkEmptyFrame(ReplayPoseSource& source) {
+    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+    source.getPoses(poses, vr::k_unMaxTrackedDeviceCount);
+    for (const vr::TrackedDevicePose_t& pose : poses) {
+        CHECK(!pose.bDeviceIsConnected && !pose.bPoseIsValid);
+    }
+}
+
+void testOnce(const std::string& path) {
+    ReplayConfig config;
+    config.path = path;
+    config.speed = 0.0;
+    ReplayPoseSource source(config);
+    CHECK(source.init());
+    for (uint32_t frame = 0; frame < kFrames; frame++) {
+        checkFrame(source, static_cast<float>(frame));
+    }
+    CHECK(!source.finished());
+    checkEmptyFrame(source);
+    CHECK(source.finished());
+    source.shutdown();
+}
+
+void testLoop(const std::string& path) {
+    ReplayConfig config;
+    config.path = path;
+    config.speed = 0.0;
+    config.loop = true;
+    ReplayPoseSource source(config);
+    CHECK(source.init());
+    for (int pass = 0; pass < 3; pass++) {
+        for (uint32_t frame = 0; frame < kFrames; frame++) {
+            checkFrame(source, static_cast<float>(frame));
+        }
+        // The jump back to the first frame is reported as a disconnect
+        checkEmptyFrame(source);
+        CHECK(!source.finished());
+    }
+    source.shutdown();
+}
+
+// Looping from a seek point restarts there, not at the start of the file
+void testLoopFromSeek(const std::string& path) {
+    ReplayConfig config;
+    config.path = path;
+    config.speed = 0.0;
+    config.loop = true;
+    config.seek = 0.0005;  // between the first and second frame, 1 ms apart
+    ReplayPoseSource source(config);
+    CHECK(source.init());
+    checkFrame(source, 1.0f);
+    checkFrame(source, 2.0f);
+    checkEmptyFrame(source);
+    checkFrame(source, 1.0f);
+    source.shutdown();
+}
+
+} // namespace
+
+int main() {
+    std::string path = writeRecording();
+    testOnce(path);
+    testLoop(path);
+    testLoopFromSeek(path);
+    std::remove(path.c_str());
+    return checkResult("test_replay");
+}
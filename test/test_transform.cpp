@@ -0,0 +1,199 @@
+// Checks the parts of transform.hpp the static_asserts cannot reach (square
+// roots and trigonometry) on random, non-trivial inputs: fromAxisAngle,
+// angle/axis, normalized, toEulerXYZ, slerp and the matrix round trip, in
+// double and float.
+
+#include <random>
+
+#include "check.hpp"
+#include "transform.hpp"
+
+using transform::Quaternion;
+using transform::RigidTransform;
+using transform::Vector3;
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+std::mt19937 rng(43);
+std::normal_distribution<double> gauss;
+std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+Vector3<double> randomAxis() {
+    Vector3<double> a{gauss(rng), gauss(rng), gauss(rng)};
+    return a * (1.0 / a.norm());
+}
+
+Quaternion<double> randomRotation() {
+    return Quaternion<double>{gauss(rng), gauss(rng), gauss(rng), gauss(rng)}.normalized();
+}
+
+// Rotation angle from a to b, in [0, pi]
+template <typename T>
+double angleBetween(const Quaternion<T>& a, const Quaternion<T>& b) {
+    return (a.conjugate() * b).angle();
+}
+
+void checkVector(const Vector3<double>& a, const Vector3<double>& b, double tolerance) {
+    CHECK_NEAR(a.x, b.x, tolerance);
+    CHECK_NEAR(a.y, b.y, tolerance);
+    CHECK_NEAR(a.z, b.z, tolerance);
+}
+
+// Against Rodrigues' formula, and back through angle() and axis()
+void testAxisAngle() {
+    for (int k = 0; k < 10000; k++) {
+        Vector3<double> axis = randomAxis();
+        double angle = kPi * uniform(rng);
+        Quaternion<double> q = Quaternion<double>::fromAxisAngle(axis, angle);
+        CHECK_NEAR(q.norm2(), 1.0, 1e-15);
+
+        Vector3<double> v{gauss(rng), gauss(rng), gauss(rng)};
+        Vector3<double> expected = v * std::cos(angle) + axis.cross(v) * std::sin(angle) +
+                                   axis * (axis.dot(v) * (1 - std::cos(angle)));
+        checkVector(q.rotate(v), expected, 1e-12);
+        checkVector(q.toMatrix() * v, expected, 1e-12);
+
+        CHECK_NEAR(q.angle(), angle, 1e-7);
+        if (angle > 1e-3) {
+            checkVector(q.axis(), axis, 1e-7);
+        }
+        // -q is the same rotation, angle and axis too
+        CHECK_NEAR((-q).angle(), angle, 1e-7);
+        checkVector((-q).axis(), q.axis(), 1e-15);
+    }
+    Quaternion<double> half_turn = Quaternion<double>::fromAxisAngle({0.0, 0.0, 1.0}, kPi);
+    checkVector(half_turn.rotate({1.0, 2.0, 3.0}), {-1.0, -2.0, 3.0}, 1e-15);
+    CHECK_NEAR(half_turn.angle(), kPi, 1e-7);
+    checkVector(Quaternion<double>::identity().axis(), {1.0, 0.0, 0.0}, 0.0);
+}
+
+void testNormalized() {
+    for (int k = 0; k < 10000; k++) {
+        Quaternion<double> u = randomRotation();
+        double scale = std::exp(10 * gauss(rng));
+        Quaternion<double> n = Quaternion<double>{u.w * scale, u.x * scale, u.y * scale, u.z * scale}.normalized();
+        CHECK_NEAR(n.norm2(), 1.0, 1e-15);
+        CHECK_NEAR(n.dot(u), 1.0, 1e-15);
+
+        Quaternion<float> f = Quaternion<float>{float(u.w * 3), float(u.x * 3), float(u.y * 3), float(u.z * 3)}.normalized();
+        CHECK_NEAR(f.norm2(), 1.0, 1e-6);
+    }
+}
+
+// toEulerXYZ inverts yaw(z) * pitch(y) * roll(x), up to the clamp at +-90
+// degrees pitch
+void testEuler() {
+    const Vector3<double> kX{1, 0, 0}, kY{0, 1, 0}, kZ{0, 0, 1};
+    for (int k = 0; k < 10000; k++) {
+        double roll = kPi * (2 * uniform(rng) - 1);
+        double pitch = 0.49 * kPi * (2 * uniform(rng) - 1);
+        double yaw = kPi * (2 * uniform(rng) - 1);
+        Quaternion<double> q = Quaternion<double>::fromAxisAngle(kZ, yaw) * Quaternion<double>::fromAxisAngle(kY, pitch) *
+                               Quaternion<double>::fromAxisAngle(kX, roll);
+        transform::EulerXYZ<double> e = q.toEulerXYZ();
+        CHECK_NEAR(e.x, roll, 1e-9);
+        CHECK_NEAR(e.y, pitch, 1e-9);
+        CHECK_NEAR(e.z, yaw, 1e-9);
+
+        // Same angles from -q
+        transform::EulerXYZ<double> n = (-q).toEulerXYZ();
+        CHECK_NEAR(n.x, e.x, 1e-12);
+        CHECK_NEAR(n.y, e.y, 1e-12);
+        CHECK_NEAR(n.z, e.z, 1e-12);
+
+        transform::EulerXYZ<float> f = Quaternion<float>{float(q.w), float(q.x), float(q.y), float(q.z)}.toEulerXYZ();
+        CHECK_NEAR(f.y, pitch, 1e-5);
+    }
+    // Gimbal lock: rounding may push sin(pitch) past 1, which is clamped
+    // instead of giving NaN
+    for (int k = 0; k < 1000; k++) {
+        double sign = k % 2 ? 1.0 : -1.0;
+        Quaternion<double> q = Quaternion<double>::fromAxisAngle(kY, sign * kPi / 2) * Quaternion<double>::fromAxisAngle(randomAxis(), 1e-9);
+        transform::EulerXYZ<double> e = q.toEulerXYZ();
+        CHECK(!std::isnan(e.x) && !std::isnan(e.y) && !std::isnan(e.z));
+        CHECK_NEAR(e.y, sign * kPi / 2, 1e-4);
+    }
+}
+
+void testSlerp() {
+    for (int k = 0; k < 10000; k++) {
+        Quaternion<double> a = randomRotation();
+        Quaternion<double> b = randomRotation();
+        double total = angleBetween(a, b);
+
+        CHECK_NEAR(angleBetween(transform::slerp(a, b, 0.0), a), 0.0, 1e-7);
+        CHECK_NEAR(angleBetween(transform::slerp(a, b, 1.0), b), 0.0, 1e-7);
+
+        // Constant angular velocity along the shortest arc: t of the way
+        // from a, 1 - t from b
+        double t = uniform(rng);
+        Quaternion<double> s = transform::slerp(a, b, t);
+        CHECK_NEAR(s.norm2(), 1.0, 1e-15);
+        CHECK_NEAR(angleBetween(a, s), t * total, 1e-7);
+        CHECK_NEAR(angleBetween(s, b), (1 - t) * total, 1e-7);
+
+        // The midpoint rotates about the same axis as the whole path
+        Quaternion<double> half = transform::slerp(a, b, 0.5);
+        Quaternion<double> step = half * a.conjugate();
+        CHECK_NEAR(angleBetween(step * step * a, b), 0.0, 1e-7);
+
+        // b and -b are the same rotation, so is the interpolation
+        Quaternion<double> negated = transform::slerp(a, -b, t);
+        CHECK_NEAR(std::fabs(negated.dot(s)), 1.0, 1e-12);
+    }
+    // Nearly equal inputs take the linear fallback, which must stay
+    // normalized and off the slerp path by no more than the nlerp error,
+    // a fraction of angle^3
+    for (int k = 0; k < 10000; k++) {
+        Quaternion<double> a = randomRotation();
+        double angle = 0.06 * uniform(rng);  // below the 0.9995 dot threshold
+        Quaternion<double> b = Quaternion<double>::fromAxisAngle(randomAxis(), angle) * a;
+        double t = uniform(rng);
+        Quaternion<double> s = transform::slerp(a, b, t);
+        CHECK_NEAR(s.norm2(), 1.0, 1e-15);
+        CHECK_NEAR(angleBetween(a, s), t * angle, angle * angle * angle / 100 + 1e-7);
+
+        Quaternion<float> af{float(a.w), float(a.x), float(a.y), float(a.z)};
+        Quaternion<float> bf{float(b.w), float(b.x), float(b.y), float(b.z)};
+        Quaternion<float> f = transform::slerp(af, bf, float(t));
+        CHECK_NEAR(angleBetween(af, f), t * angle, 1e-3);
+        CHECK_NEAR(f.norm2(), 1.0, 1e-6);
+    }
+}
+
+// quaternion -> matrix -> quaternion, near 180 degrees included, and the
+// rigid transforms built on it
+void testMatrixRoundTrip() {
+    for (int k = 0; k < 10000; k++) {
+        Quaternion<double> q = k % 2 ? randomRotation()
+                                     : Quaternion<double>::fromAxisAngle(randomAxis(), kPi - 1e-4 * uniform(rng));
+        Quaternion<double> back = Quaternion<double>::fromMatrix(q.toMatrix());
+        CHECK(back.w >= 0);
+        CHECK_NEAR(std::fabs(back.dot(q)), 1.0, 1e-14);
+        CHECK_NEAR(angleBetween(back, q), 0.0, 1e-7);
+
+        Quaternion<float> qf{float(q.w), float(q.x), float(q.y), float(q.z)};
+        Quaternion<float> backf = Quaternion<float>::fromMatrix(qf.toMatrix());
+        CHECK_NEAR(std::fabs(backf.dot(qf)), 1.0, 1e-6);
+
+        RigidTransform<double> a = RigidTransform<double>::fromQuaternion(q, {gauss(rng), gauss(rng), gauss(rng)});
+        RigidTransform<double> b = RigidTransform<double>::fromQuaternion(randomRotation(), {gauss(rng), gauss(rng), gauss(rng)});
+        Vector3<double> p{gauss(rng), gauss(rng), gauss(rng)};
+        checkVector((a * b) * p, a * (b * p), 1e-12);
+        checkVector(a.inverse() * (a * p), p, 1e-12);
+        CHECK_NEAR(std::fabs((a * b).orientation().dot(q * b.orientation())), 1.0, 1e-12);
+    }
+}
+
+} // namespace
+
+int main() {
+    testAxisAngle();
+    testNormalized();
+    testEuler();
+    testSlerp();
+    testMatrixRoundTrip();
+    return checkResult("test_transform");
+}
@@ -0,0 +1,224 @@
+// Runs known SteamVR samples through the vive_node output path
+// (convertAxes, then the TF, twist and tracker_data messages) and checks
+// that all outputs agree with each other and with REP-103.
+
+#include <random>
+
+#include "check.hpp"
+#include "transform.hpp"
+#include "vive_messages.hpp"
+
+using transform::Quaternion;
+using transform::Vector3;
+
+namespace {
+
+constexpr double kTolerance = 1e-6;
+
+VRControllerData steamVRSample(const Vector3<double>& p, const Quaternion<double>& q, const Vector3<double>& v,
+                               const Vector3<double>& w) {
+    VRControllerData data;
+    VRUtils::resetJsonData(data);
+    data.pose_x = p.x;
+    data.pose_y = p.y;
+    data.pose_z = p.z;
+    data.pose_qx = q.x;
+    data.pose_qy = q.y;
+    data.pose_qz = q.z;
+    data.pose_qw = q.w;
+    // A different raw pose, so a swapped field would show
+    data.raw_x = p.x + 0.1f;
+    data.raw_y = p.y - 0.2f;
+    data.raw_z = p.z + 0.3f;
+    data.raw_qx = q.y;
+    data.raw_qy = q.z;
+    data.raw_qz = q.x;
+    data.raw_qw = q.w;
+    data.vel_x = v.x;
+    data.vel_y = v.y;
+    data.vel_z = v.z;
+    data.ang_vel_x = w.x;
+    data.ang_vel_y = w.y;
+    data.ang_vel_z = w.z;
+    return data;
+}
+
+Vector3<double> toRos(const Vector3<double>& v) {
+    Vector3<double> out;
+    vive_messages::WireToOutput::vector(v.x, v.y, v.z, out.x, out.y, out.z);
+    return out;
+}
+
+Quaternion<double> rotation(const geometry_msgs::msg::Quaternion& q) {
+    return {q.w, q.x, q.y, q.z};
+}
+
+void checkVector(const geometry_msgs::msg::Vector3& a, const Vector3<double>& b) {
+    CHECK_NEAR(a.x, b.x, kTolerance);
+    CHECK_NEAR(a.y, b.y, kTolerance);
+    CHECK_NEAR(a.z, b.z, kTolerance);
+}
+
+void checkRotation(const Quaternion<double>& a, const Quaternion<double>& b) {
+    // q and -q are the same rotation
+    CHECK_NEAR(std::fabs(a.dot(b)), 1.0, kTolerance);
+}
+
+bool sameStamp(const builtin_interfaces::msg::Time& a, const builtin_interfaces::msg::Time& b) {
+    return a.sec == b.sec && a.nanosec == b.nanosec;
+}
+
+void checkTransformsEqual(const geometry_msgs::msg::TransformStamped& a, const geometry_msgs::msg::TransformStamped& b) {
+    CHECK(a.header.frame_id == b.header.frame_id);
+    CHECK(a.child_frame_id == b.child_frame_id);
+    CHECK(sameStamp(a.header.stamp, b.header.stamp));
+    CHECK(a.transform.translation.x == b.transform.translation.x);
+    CHECK(a.transform.translation.y == b.transform.translation.y);
+    CHECK(a.transform.translation.z == b.transform.translation.z);
+    CHECK(a.transform.rotation.x == b.transform.rotation.x);
+    CHECK(a.transform.rotation.y == b.transform.rotation.y);
+    CHECK(a.transform.rotation.z == b.transform.rotation.z);
+    CHECK(a.transform.rotation.w == b.transform.rotation.w);
+}
+
+struct Outputs {
+    geometry_msgs::msg::TransformStamped tf;
+    geometry_msgs::msg::TwistStamped twist;
+    vive_ros2::msg::VRControllerData tracker;
+};
+
+Outputs publish(VRControllerData data, const std::string& serial = "LHR-TEST") {
+    builtin_interfaces::msg::Time stamp = vive_messages::stampFromNs(data.time_ns);
+    vive_messages::convertAxes(data);
+    Outputs out;
+    vive_messages::fillTransform(data, vive_messages::trackerFrame(data.device, serial), stamp, out.tf);
+    vive_messages::fillTwist(data, stamp, out.twist);
+    vive_messages::fillTrackerData(data, serial, "t", stamp, out.tracker);
+    return out;
+}
+
+// TF, vive_twist and tracker_data carry the same converted numbers
+void checkAgreement(const Outputs& out) {
+    checkTransformsEqual(out.tf, out.tracker.abs_pose);
+    CHECK(out.twist.header.frame_id == out.tf.header.frame_id);
+    CHECK(sameStamp(out.twist.header.stamp, out.tf.header.stamp));
+    CHECK(out.twist.twist.linear.x == out.tracker.velocity.linear.x);
+    CHECK(out.twist.twist.linear.y == out.tracker.velocity.linear.y);
+    CHECK(out.twist.twist.linear.z == out.tracker.velocity.linear.z);
+    CHECK(out.twist.twist.angular.x == out.tracker.velocity.angular.x);
+    CHECK(out.twist.twist.angular.y == out.tracker.velocity.angular.y);
+    CHECK(out.twist.twist.angular.z == out.tracker.velocity.angular.z);
+}
+
+// A tracker 2 m in front, 0.5 m to the right and 1.2 m up, turned 90 degrees
+// to the left, moving forward and turning left: in REP-103 that is
+// x = 2, y = -0.5, z = 1.2, yaw +90 degrees, v = +x, omega = +z.
+void testKnownPose() {
+    Quaternion<double> yaw_left = Quaternion<double>::fromAxisAngle({0.0, 1.0, 0.0}, M_PI / 2);
+    VRControllerData data = steamVRSample({0.5, 1.2, -2.0}, yaw_left, {0.0, 0.0, -1.0}, {0.0, 0.5, 0.0});
+    data.time_ns = 1700000012000000345;
+    Outputs out = publish(data);
+    checkAgreement(out);
+
+    // Stamped with the sample time, the time base of the LookupPose service
+    CHECK(out.tf.header.stamp.sec == 1700000012 && out.tf.header.stamp.nanosec == 345);
+
+    checkVector(out.tf.transform.translation, {2.0, -0.5, 1.2});
+    checkRotation(rotation(out.tf.transform.rotation), Quaternion<double>::fromAxisAngle({0.0, 0.0, 1.0}, M_PI / 2));
+    checkVector(out.twist.twist.linear, {1.0, 0.0, 0.0});
+    checkVector(out.twist.twist.angular, {0.0, 0.0, 0.5});
+    CHECK(out.tf.header.frame_id == "world");
+    CHECK(out.tf.child_frame_id == "vive_tracker_LHR-TEST");
+
+    // The tracker's forward axis (SteamVR -z) points along REP-103 +y after the yaw
+    Vector3<double> forward = rotation(out.tf.transform.rotation).rotate(toRos({0.0, 0.0, -1.0}));
+    CHECK_NEAR(forward.x, 0.0, kTolerance);
+    CHECK_NEAR(forward.y, 1.0, kTolerance);
+    CHECK_NEAR(forward.z, 0.0, kTolerance);
+}
+
+// On random samples: the published rotation maps converted vectors like the
+// wire rotation maps wire vectors, the raw pose goes through the same
+// conversion, and the published angular velocity integrates the published
+// orientation the way the wire one integrates the wire orientation.
+void testRandomSamples() {
+    std::mt19937 rng(35);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    auto randomVector = [&] { return Vector3<double>{uniform(rng), uniform(rng), uniform(rng)}; };
+    for (int k = 0; k < 200; k++) {
+        Vector3<double> p = randomVector() * 3.0;
+        Quaternion<double> q = Quaternion<double>{uniform(rng), uniform(rng), uniform(rng), uniform(rng)}.normalized();
+        Vector3<double> v = randomVector();
+        Vector3<double> w = randomVector() * 4.0;
+        VRControllerData sample = steamVRSample(p, q, v, w);
+        Outputs out = publish(sample);
+        checkAgreement(out);
+
+        // Rebuild the float inputs the way the node saw them
+        Vector3<double> wire_p{sample.pose_x, sample.pose_y, sample.pose_z};
+        Quaternion<double> wire_q{sample.pose_qw, sample.pose_qx, sample.pose_qy, sample.pose_qz};
+        Vector3<double> wire_w{sample.ang_vel_x, sample.ang_vel_y, sample.ang_vel_z};
+        Quaternion<double> ros_q = rotation(out.tf.transform.rotation);
+
+        checkVector(out.tf.transform.translation, toRos(wire_p));
+        checkVector(out.twist.twist.linear, toRos({sample.vel_x, sample.vel_y, sample.vel_z}));
+        checkVector(out.tracker.raw_pose.transform.translation, toRos({sample.raw_x, sample.raw_y, sample.raw_z}));
+        Vector3<double> u = randomVector();
+        Vector3<double> rotated = toRos(wire_q.rotate(u));
+        Vector3<double> expected = ros_q.rotate(toRos(u));
+        CHECK_NEAR(rotated.x, expected.x, kTolerance);
+        CHECK_NEAR(rotated.y, expected.y, kTolerance);
+        CHECK_NEAR(rotated.z, expected.z, kTolerance);
+        Quaternion<double> raw_q{sample.raw_qw, sample.raw_qx, sample.raw_qy, sample.raw_qz};
+        Vector3<double> raw_rotated = toRos(raw_q.rotate(u));
+        Vector3<double> raw_expected = rotation(out.tracker.raw_pose.transform.rotation).rotate(toRos(u));
+        CHECK_NEAR(raw_rotated.x, raw_expected.x, kTolerance);
+        CHECK_NEAR(raw_rotated.y, raw_expected.y, kTolerance);
+        CHECK_NEAR(raw_rotated.z, raw_expected.z, kTolerance);
+
+        // Angular velocity in the world frame: q(t + dt) = exp(w dt) q(t) on both sides
+        const double dt = 0.01;
+        double rate = wire_w.norm();
+        Quaternion<double> wire_next = Quaternion<double>::fromAxisAngle(wire_w * (1.0 / rate), rate * dt) * wire_q;
+        Vector3<double> ros_w{out.twist.twist.angular.x, out.twist.twist.angular.y, out.twist.twist.angular.z};
+        Quaternion<double> ros_next = Quaternion<double>::fromAxisAngle(ros_w * (1.0 / ros_w.norm()), ros_w.norm() * dt) * ros_q;
+        Vector3<double> a = toRos(wire_next.rotate(u));
+        Vector3<double> b = ros_next.rotate(toRos(u));
+        CHECK_NEAR(a.x, b.x, kTolerance);
+        CHECK_NEAR(a.y, b.y, kTolerance);
+        CHECK_NEAR(a.z, b.z, kTolerance);
+    }
+}
+
+// Two devices of one poll get their own frames and carry index and serial,
+// so TF and tracker_data subscribers can tell them apart; a device whose
+// metadata has not arrived yet is named by index
+void testTwoDevices() {
+    Quaternion<double> q = Quaternion<double>::fromAxisAngle({0.0, 1.0, 0.0}, 0.3);
+    VRControllerData a = steamVRSample({0.5, 1.2, -2.0}, q, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0});
+    VRControllerData b = steamVRSample({-1.0, 0.8, 1.0}, q.conjugate(), {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0});
+    a.device = 1;
+    b.device = 4;
+    Outputs out_a = publish(a, "LHR-AAAA");
+    Outputs out_b = publish(b, "");
+    checkAgreement(out_a);
+    checkAgreement(out_b);
+
+    CHECK(out_a.tf.child_frame_id == "vive_tracker_LHR-AAAA");
+    CHECK(out_b.tf.child_frame_id == "vive_tracker_4");
+    CHECK(out_a.tracker.raw_pose.child_frame_id == "vive_tracker_LHR-AAAA_raw");
+    CHECK(out_b.tracker.raw_pose.child_frame_id == "vive_tracker_4_raw");
+    CHECK(out_a.tracker.device == 1 && out_a.tracker.serial == "LHR-AAAA");
+    CHECK(out_b.tracker.device == 4 && out_b.tracker.serial.empty());
+    checkVector(out_a.tf.transform.translation, toRos({0.5, 1.2, -2.0}));
+    checkVector(out_b.tf.transform.translation, toRos({-1.0, 0.8, 1.0}));
+}
+
+} // namespace
+
+int main() {
+    testKnownPose();
+    testRandomSamples();
+    testTwoDevices();
+    return checkResult("test_vive_messages");
+}